@@ -1,9 +1,12 @@
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <iostream>
 #include <chrono>
 #include <sstream>
 
 #include "game_loop.h"
+#include "triple_buffer.h"
 #include "utils.h"
 
 #include <tics.h>
@@ -20,8 +23,9 @@ using namespace std::chrono_literals;
 
 auto accumulated_render_time = 0ns;
 unsigned int accumulated_render_time_count = 0;
-auto accumulated_physics_time = 0ns;
-unsigned int accumulated_physics_time_count = 0;
+// written by the physics thread
+std::atomic<std::chrono::nanoseconds::rep> accumulated_physics_time = 0;
+std::atomic<unsigned int> accumulated_physics_time_count = 0;
 
 struct AreaTrigger {
 	const std::shared_ptr<tics::CollisionArea> area;
@@ -35,6 +39,18 @@ struct RaycastTarget {
 	std::shared_ptr<ron::MeshNode> mesh_node;
 };
 
+struct SphereTransforms {
+	tics::Transform previous;
+	tics::Transform current;
+};
+
+// published by the physics thread after every physics update
+struct PhysicsFrame {
+	// when the update was due, the render interpolates by the time since then
+	std::chrono::high_resolution_clock::time_point due = {};
+	std::vector<SphereTransforms> spheres = {};
+};
+
 struct ProgramState {
 	std::shared_ptr<std::vector<Sphere>> spheres;
 	std::shared_ptr<std::vector<StaticObject>> static_geometry;
@@ -49,17 +65,27 @@ struct ProgramState {
 	std::shared_ptr<tics::ImpulseSolver> impulse_solver;
 	std::shared_ptr<tics::NonIntersectionConstraintSolver> position_solver;
 	std::shared_ptr<tics::CollisionAreaSolver> collision_area_solver;
+
+	// transforms of the spheres before and after the last physics update
+	TripleBuffer<PhysicsFrame> physics_frames = {};
+	// render thread only, reused every frame
+	std::vector<tics::Transform> interpolated_transforms = {};
+	std::vector<glm::mat4> model_matrices = {};
 };
 
 static void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 static void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 static ProgramState initialize(GLFWwindow* window);
-static void process(GLFWwindow* window, ProgramState& state);
-static void render(GLFWwindow* window, ProgramState& state);
+static void process_input(GLFWwindow* window, ProgramState& state);
+static void process_physics(ProgramState& state, const float delta, const std::chrono::high_resolution_clock::time_point due);
+static void render(GLFWwindow* window, ProgramState& state, const std::chrono::high_resolution_clock::time_point frame_start);
 
 const int res_x = 1000;
 const int res_y = 600;
 
+// rendering interpolates between the physics steps, so physics can run slower than the display
+const float physics_delta = 1.0f/30.0f;
+
 int main() {
 	glfwInit();
 
@@ -89,11 +115,19 @@ int main() {
 		ProgramState state = initialize(window);
 		glfwSetWindowUserPointer(window, static_cast<void *>(&state));
 
+		// physics runs on its own thread, so slow frames don't stall it (and the other way around).
+		// game_loop is destroyed before state, which stops the physics thread before its state is gone.
+		// the due time of a physics update is published with its results, so the render interpolates
+		// the state it reads by exactly the time since that state was due
 		GameLoop game_loop(
-			[window, &state](const float delta, const float fixed_delay) { render(window, state); },
-			[window, &state](const float delta) { process(window, state); },
-			1.0f/60.0f, 0.0f, 1.0f/60.0f
+			[window, &state, &game_loop](const float delta, const float fixed_delay) {
+				process_input(window, state);
+				render(window, state, game_loop.update_start());
+			},
+			[&state, &game_loop](const float delta) { process_physics(state, delta, game_loop.fixed_update_due()); },
+			physics_delta, 0.0f, 1.0f/60.0f
 		);
+		game_loop.start_fixed_update_thread();
 
 		auto last_title_update_time_point = std::chrono::high_resolution_clock::now();
 
@@ -114,14 +148,12 @@ int main() {
 				accumulated_render_time = 0ns;
 				accumulated_render_time_count = 0;
 
+				const auto physics_time_count = std::max(accumulated_physics_time_count.exchange(0), 1u);
 				const auto avg_physics_time = std::chrono::duration<double>(
-					accumulated_physics_time / accumulated_physics_time_count
+					std::chrono::nanoseconds(accumulated_physics_time.exchange(0)) / physics_time_count
 				);
 				const double avg_physics_time_ms = avg_physics_time.count() * 1000.0;
 
-				accumulated_physics_time = 0ns;
-				accumulated_physics_time_count = 0;
-
 				std::stringstream title_stream;
 				title_stream
 					<< "Physics Playground"
@@ -315,6 +347,8 @@ ProgramState initialize(GLFWwindow* window) {
 	};
 	area_trigger.area->set_collider(area_trigger.collider);
 	area_trigger.area->set_transform(area_trigger.transform);
+	// the callback prints and marks the contact point
+	area_trigger.area->report_contact_data = true;
 	area_trigger.area->on_collision_enter = [spheres, scene](const auto &other, const auto &collision_data) {
 		std::cout << "collision_data: normal: {"
 			<< collision_data.normal.x << "," << collision_data.normal.y << "," << collision_data.normal.z << "}"
@@ -390,7 +424,8 @@ ProgramState initialize(GLFWwindow* window) {
 	};
 }
 
-void process(GLFWwindow* window, ProgramState& state) {
+// runs on the main thread, glfw input can only be used there
+void process_input(GLFWwindow* window, ProgramState& state) {
 	glfwPollEvents();
 
 	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
@@ -398,6 +433,11 @@ void process(GLFWwindow* window, ProgramState& state) {
 		return;
 	}
 
+	state.camera_controls.update(*window, state.camera);
+}
+
+// runs on the physics thread, it only touches the render state through physics_frames
+void process_physics(ProgramState& state, const float delta, const std::chrono::high_resolution_clock::time_point due) {
 	auto start_time_point = std::chrono::high_resolution_clock::now();
 
 	// add random impulses for dynamics benchmark
@@ -459,30 +499,59 @@ void process(GLFWwindow* window, ProgramState& state) {
 
 
 	const float time_scale = 1.0f;
-	const float delta = time_scale/60.0f;
+	const float scaled_delta = time_scale * delta;
 
 	const float time_limit = 20.0f; // seconds
 	static float total_time = 0;
 
-	if (total_time < time_limit) {
-		state.physics_world.update(delta);
-		total_time += delta;
+	const bool stepped = total_time < time_limit;
+	if (stepped) {
+		state.physics_world.update(scaled_delta);
+		total_time += scaled_delta;
 	}
 
 	const auto physics_time = std::chrono::high_resolution_clock::now() - start_time_point;
 	++accumulated_physics_time_count;
-	accumulated_physics_time += physics_time;
-
-	for (const auto &sphere : *state.spheres) {
-		sphere.mesh_node->set_model_matrix(transform_to_model_matrix(*sphere.transform));
+	accumulated_physics_time += std::chrono::duration_cast<std::chrono::nanoseconds>(physics_time).count();
+
+	auto &frame = state.physics_frames.get_write_buffer();
+	frame.due = due;
+	auto &sphere_transforms = frame.spheres;
+	sphere_transforms.resize(state.spheres->size());
+	for (size_t i = 0; i < state.spheres->size(); i++) {
+		const auto &sphere = (*state.spheres)[i];
+		// without a step the spheres stay where they are, instead of repeating the last step forever
+		const auto &previous = stepped ? sphere.rigid_body->previous_transform : *sphere.transform;
+		sphere_transforms[i] = { previous, *sphere.transform };
 	}
-
-	state.camera_controls.update(*window, state.camera);
+	state.physics_frames.publish();
 }
 
-void render(GLFWwindow* window, ProgramState& state) {
+// frame_start: the time the frame is rendered for
+void render(GLFWwindow* window, ProgramState& state, const std::chrono::high_resolution_clock::time_point frame_start) {
 	auto start_time_point = std::chrono::high_resolution_clock::now();
 
+	state.physics_frames.update_read_buffer();
+	const auto &frame = state.physics_frames.get_read_buffer();
+	const auto &sphere_transforms = frame.spheres;
+	// time since the physics update was due, in physics steps
+	const std::chrono::duration<float> since_due = frame_start - frame.due;
+	const auto alpha = std::clamp(since_due.count() / physics_delta, 0.0f, 1.0f);
+	auto &transforms = state.interpolated_transforms;
+	transforms.resize(sphere_transforms.size());
+	for (size_t i = 0; i < sphere_transforms.size(); i++) {
+		transforms[i] = tics::interpolate(sphere_transforms[i].previous, sphere_transforms[i].current, alpha);
+	}
+	// all model matrices in one batch, glm::mat4 is column major like the output
+	auto &model_matrices = state.model_matrices;
+	model_matrices.resize(transforms.size());
+	tics::write_transform_matrices(
+		transforms, std::span<float>(reinterpret_cast<float *>(model_matrices.data()), model_matrices.size() * 16)
+	);
+	for (size_t i = 0; i < model_matrices.size(); i++) {
+		(*state.spheres)[i].mesh_node->set_model_matrix(model_matrices[i]);
+	}
+
 	state.renderer->render(*(state.render_scene), state.camera);
 
 	const auto render_time = std::chrono::high_resolution_clock::now() - start_time_point;
@@ -167,15 +167,7 @@ ProgramState initialize(GLFWwindow* window) {
 	for (const auto &vertex_pos : raycast_target_geometry->positions) {
 		raycast_target.collider->positions.push_back(Terathon::Vector3D(vertex_pos.x, vertex_pos.y, vertex_pos.z));
 	}
-	raycast_target.collider->edges = std::vector<Terathon::Line3D>(raycast_target.collider->indices.size() / 3);
-	for (size_t triangle_index = 0; triangle_index < raycast_target.collider->indices.size() / 3; triangle_index++) {
-		auto a = Terathon::Point3D(raycast_target.collider->positions.at(raycast_target.collider->indices.at(triangle_index * 3 + 0)));
-		auto b = Terathon::Point3D(raycast_target.collider->positions.at(raycast_target.collider->indices.at(triangle_index * 3 + 1)));
-		auto c = Terathon::Point3D(raycast_target.collider->positions.at(raycast_target.collider->indices.at(triangle_index * 3 + 2)));
-		b -= a; c -= a;
-		const auto e_bc = Terathon::Wedge(b, c);
-		raycast_target.collider->edges.at(triangle_index) = e_bc;
-	}
+	tics::cook_mesh_collider(*raycast_target.collider);
 	scene.add(raycast_target.mesh_node);
 
 	// raycasting setup - second target
@@ -189,6 +181,7 @@ ProgramState initialize(GLFWwindow* window) {
 	for (const auto &vertex_pos : raycast_target_2_geometry->positions) {
 		raycast_target_2.collider->positions.push_back(Terathon::Vector3D(vertex_pos.x, vertex_pos.y, vertex_pos.z));
 	}
+	tics::cook_mesh_collider(*raycast_target_2.collider);
 	// scene.add(raycast_target_2.mesh_node);
 
 	renderer->preload(scene);
@@ -1,5 +1,6 @@
 #include "game_loop.h"
 
+#include <algorithm>
 #include <chrono>
 #include <thread>
 
@@ -13,9 +14,31 @@ GameLoop::GameLoop(
 		variable_delta_min(variable_update_delta_min),
 		variable_delta_max(variable_update_delta_max),
 		m_last_update_start( std::chrono::high_resolution_clock::now() ),
-		m_fixed_delay(0.0f)
+		m_fixed_delay(0.0f),
+		m_fixed_update_due( m_last_update_start )
 	{ }
 
+GameLoop::~GameLoop() {
+	stop_fixed_update_thread();
+}
+
+void GameLoop::idle_until(const std::chrono::high_resolution_clock::time_point time) const {
+	switch (idle_method) {
+		case BUSY_SLEEP:
+			while (std::chrono::high_resolution_clock::now() < time) { }
+			break;
+		case THREAD_SLEEP:
+			std::this_thread::sleep_until(time);
+			break;
+		case HYBRID_SLEEP:
+			std::this_thread::sleep_until(
+				time - std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(spin_duration)
+			);
+			while (std::chrono::high_resolution_clock::now() < time) { }
+			break;
+	}
+}
+
 void GameLoop::update() const {
 	auto start_time = std::chrono::high_resolution_clock::now();
 
@@ -32,14 +55,7 @@ void GameLoop::update() const {
 		auto destination_time = start_time
 			+ std::chrono::duration_cast<std::chrono::nanoseconds>(wait_time);
 
-		switch (idle_method) {
-			case BUSY_SLEEP:
-				while (std::chrono::high_resolution_clock::now() < destination_time) { }
-				break;
-			case THREAD_SLEEP:
-				std::this_thread::sleep_until(destination_time);
-				break;
-		}
+		idle_until(destination_time);
 
 		auto now = std::chrono::high_resolution_clock::now();
 		delta = now - m_last_update_start;
@@ -48,12 +64,62 @@ void GameLoop::update() const {
 	else {
 		m_last_update_start = std::chrono::high_resolution_clock::now();
 	}
+
+	if (is_fixed_update_threaded()) {
+		const auto last_fixed_update_due = std::chrono::high_resolution_clock::time_point(
+			std::chrono::high_resolution_clock::duration(m_last_fixed_update_due.load(std::memory_order_acquire))
+		);
+		const std::chrono::duration<float> fixed_delay = m_last_update_start - last_fixed_update_due;
+		m_variable_update(
+			delta.count(),
+			std::clamp(fixed_delay, std::chrono::duration<float>(0.0f), fixed_delta).count()
+		);
+		return;
+	}
+
 	m_fixed_delay += delta;
 
 	while (m_fixed_delay >= fixed_delta) {
+		m_fixed_update_due = m_last_update_start
+			- std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(m_fixed_delay - fixed_delta);
 		m_fixed_update(fixed_delta.count());
 		m_fixed_delay -= fixed_delta;
 	}
 
 	m_variable_update(delta.count(), m_fixed_delay.count());
 }
+
+void GameLoop::start_fixed_update_thread() {
+	if (is_fixed_update_threaded()) { return; }
+	m_last_fixed_update_due.store(
+		std::chrono::high_resolution_clock::now().time_since_epoch().count(), std::memory_order_release
+	);
+	m_fixed_update_thread_running = true;
+	m_fixed_update_thread = std::thread(&GameLoop::run_fixed_updates, this);
+}
+
+void GameLoop::stop_fixed_update_thread() {
+	if (!is_fixed_update_threaded()) { return; }
+	m_fixed_update_thread_running = false;
+	m_fixed_update_thread.join();
+	m_fixed_delay = std::chrono::duration<float>(0.0f);
+}
+
+void GameLoop::run_fixed_updates() {
+	const auto fixed_delta_duration = std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(fixed_delta);
+	auto due = std::chrono::high_resolution_clock::now();
+
+	while (m_fixed_update_thread_running.load(std::memory_order_relaxed)) {
+		m_fixed_update_due = due;
+		m_fixed_update(fixed_delta.count());
+		m_last_fixed_update_due.store(due.time_since_epoch().count(), std::memory_order_release);
+
+		due += fixed_delta_duration;
+		// fixed updates that are slower than real time can't catch up, skip the missed time (the game slows down)
+		const auto now = std::chrono::high_resolution_clock::now();
+		if (now - due > variable_delta_max) {
+			due = now;
+		}
+		idle_until(due);
+	}
+}
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <functional>
+#include <thread>
 
 class GameLoop {
 public:
@@ -13,22 +15,48 @@ public:
 		// if the max delta time is not met, the game time will slow down
 		const float variable_update_delta_max_seconds = 0.2f
 	);
-	~GameLoop() = default;
+	~GameLoop();
 
 	const std::chrono::duration<float> fixed_delta;
 	std::chrono::duration<float> variable_delta_min;
 	std::chrono::duration<float> variable_delta_max;
 
 	// tradeoff: busy sleep is more reliable,
-	// thread sleep results in less cpu utilization and is OS dependent
-	enum IdleMethod { BUSY_SLEEP, THREAD_SLEEP };
+	// thread sleep results in less cpu utilization and is OS dependent (it can oversleep by a few ms).
+	// hybrid sleep thread sleeps until spin_duration before the wake up time and busy sleeps the rest
+	enum IdleMethod { BUSY_SLEEP, THREAD_SLEEP, HYBRID_SLEEP };
 
-	IdleMethod idle_method = BUSY_SLEEP;
+	IdleMethod idle_method = HYBRID_SLEEP;
+	std::chrono::duration<float> spin_duration = std::chrono::duration<float>(0.002f);
 
 	void update() const;
+
+	// runs the fixed update on its own thread every fixed_delta, update() then only runs the variable update.
+	// the fixed update has to hand its results to the variable update itself (see TripleBuffer),
+	// the fixed_delay passed to the variable update is the time since the last completed fixed update was due.
+	// a fixed update can complete between the two, so to interpolate the handed over results, hand over
+	// fixed_update_due() with them and measure the delay from update_start() instead
+	void start_fixed_update_thread();
+	// waits for the running fixed update to finish
+	void stop_fixed_update_thread();
+	bool is_fixed_update_threaded() const { return m_fixed_update_thread.joinable(); }
+
+	// only in the fixed update: the time it was due
+	std::chrono::high_resolution_clock::time_point fixed_update_due() const { return m_fixed_update_due; }
+	// only in the variable update: the time the current update started
+	std::chrono::high_resolution_clock::time_point update_start() const { return m_last_update_start; }
 private:
 	const std::function<void(float, float)> m_variable_update;
 	const std::function<void(float)> m_fixed_update;
 	std::chrono::high_resolution_clock::time_point mutable m_last_update_start;
 	std::chrono::duration<float> mutable m_fixed_delay;
+	std::chrono::high_resolution_clock::time_point mutable m_fixed_update_due;
+
+	std::thread m_fixed_update_thread;
+	std::atomic<bool> m_fixed_update_thread_running = false;
+	// time_since_epoch of the time the last completed fixed update was due
+	std::atomic<std::chrono::high_resolution_clock::rep> m_last_fixed_update_due = 0;
+
+	void idle_until(const std::chrono::high_resolution_clock::time_point time) const;
+	void run_fixed_updates();
 };
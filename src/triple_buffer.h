@@ -0,0 +1,40 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// hands complete states from one producer thread to one consumer thread without locks.
+// the producer writes into its own buffer and publishes it, the consumer reads the latest published buffer.
+// neither side ever waits: with three buffers there is always one free for the producer,
+// states the consumer didn't pick up in time are overwritten by newer ones
+template <typename T>
+class TripleBuffer {
+public:
+	TripleBuffer() = default;
+	TripleBuffer(const T &initial) : m_buffers({ initial, initial, initial }) { }
+
+	// producer
+	T &get_write_buffer() { return m_buffers[m_write]; }
+	void publish() {
+		m_write = m_shared.exchange(m_write | NEW_STATE, std::memory_order_acq_rel) & INDEX;
+	}
+
+	// consumer
+	// takes the latest published state, returns false (and keeps the current one) if nothing new was published
+	bool update_read_buffer() {
+		if (!(m_shared.load(std::memory_order_relaxed) & NEW_STATE)) { return false; }
+		m_read = m_shared.exchange(m_read, std::memory_order_acq_rel) & INDEX;
+		return true;
+	}
+	const T &get_read_buffer() const { return m_buffers[m_read]; }
+private:
+	// the shared index also carries whether its buffer holds a state the consumer hasn't seen yet
+	static constexpr uint8_t INDEX = 0b011;
+	static constexpr uint8_t NEW_STATE = 0b100;
+
+	std::array<T, 3> m_buffers = {};
+	uint8_t m_write = 0;
+	std::atomic<uint8_t> m_shared = 1;
+	uint8_t m_read = 2;
+};
@@ -11,10 +11,17 @@
 #include <TSMatrix4D.h>
 #include <TSMotor3D.h>
 
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <tuple>
+
 struct Sphere {
 	const std::shared_ptr<tics::RigidBody> rigid_body;
 	const std::shared_ptr<tics::Transform> transform;
-	const std::shared_ptr<tics::MeshCollider> collider;
+	const std::shared_ptr<tics::ScaledMeshCollider> collider;
 	std::shared_ptr<ron::MeshNode> mesh_node;
 	glm::vec3 color;
 };
@@ -22,7 +29,7 @@ struct Sphere {
 struct StaticObject {
 	const std::shared_ptr<tics::StaticBody> static_body;
 	const std::shared_ptr<tics::Transform> transform;
-	const std::shared_ptr<tics::MeshCollider> collider;
+	const std::shared_ptr<tics::TriangleMeshCollider> collider;
 };
 
 glm::mat4 transform_to_model_matrix(const tics::Transform &transform) {
@@ -59,6 +66,45 @@ glm::mat4 transform_to_model_matrix(const tics::Transform &transform) {
 #endif
 }
 
+// collision mesh of a mesh node of a glTF file, cooked. T is tics::MeshCollider (convex hull)
+// or tics::TriangleMeshCollider (concave level geometry).
+// the cooked collider is cached on disk in cooked/, a changed glTF file or node is imported and cooked again.
+// all callers with the same file and node share one collider, scaled instances use a tics::ScaledMeshCollider
+template <typename T = tics::MeshCollider>
+std::shared_ptr<T> load_mesh_collider(const std::string &gltf_path, const size_t mesh_node_index = 0) {
+	static std::map<std::tuple<std::string, size_t>, std::shared_ptr<T>> loaded;
+	const auto key = std::make_tuple(gltf_path, mesh_node_index);
+	if (const auto it = loaded.find(key); it != loaded.end()) { return it->second; }
+
+	// the hash covers the source file and everything that changes the collider
+	std::ifstream file(gltf_path, std::ios::binary);
+	const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	const uint64_t settings [1] = { mesh_node_index };
+	const auto source_hash = tics::content_hash(
+		std::span(reinterpret_cast<const uint8_t *>(settings), sizeof(settings)), tics::content_hash(bytes)
+	);
+	std::stringstream cooked_path;
+	cooked_path
+		<< "cooked/" << std::filesystem::path(gltf_path).stem().string()
+		<< "_" << std::hex << source_hash << ".tcol";
+
+	auto collider = std::make_shared<T>();
+	if (!tics::load_cooked_mesh_collider(cooked_path.str(), source_hash, *collider)) {
+		const auto geometry = ron::gltf::import(gltf_path).get_mesh_nodes().at(mesh_node_index)
+			->get_mesh()->sections.front().geometry;
+		// copy positions and inidices to MeshCollider
+		collider->indices = geometry->indices;
+		for (const auto &vertex_pos : geometry->positions) {
+			collider->positions.push_back(Terathon::Vector3D(vertex_pos.x, vertex_pos.y, vertex_pos.z));
+		}
+		tics::cook_mesh_collider(*collider);
+		std::filesystem::create_directories("cooked");
+		tics::save_cooked_mesh_collider(cooked_path.str(), *collider, source_hash);
+	}
+	loaded[key] = collider;
+	return collider;
+}
+
 ron::DirectionalLight create_generic_light() {
 	ron::DirectionalLight light = {};
 
@@ -82,10 +128,14 @@ Sphere create_sphere(
 	Sphere sphere = Sphere({
 		std::make_shared<tics::RigidBody>(),
 		std::make_shared<tics::Transform>(),
-		std::make_shared<tics::MeshCollider>(),
+		std::make_shared<tics::ScaledMeshCollider>(),
 		ron::gltf::import("models/cube.glb").get_mesh_nodes().front(),
 	});
 
+	// all spheres share one icosphere
+	sphere.collider->mesh = load_mesh_collider("models/icosphere_smooth.glb");
+	sphere.collider->scale = Terathon::Vector3D(scale, scale, scale);
+
 	sphere.rigid_body->set_collider(sphere.collider);
 	sphere.rigid_body->set_transform(sphere.transform);
 	sphere.rigid_body->mass = scale*scale*scale * 2.0;
@@ -116,18 +166,6 @@ Sphere create_sphere(
 	cloned_mesh_node->get_mesh()->sections.front().material = material;
 	sphere.mesh_node = cloned_mesh_node;
 
-	const auto geometry = ron::gltf::import("models/icosphere_smooth.glb").get_mesh_nodes()
-		.front()->get_mesh()->sections.front().geometry;
-	// apply scale to collision mesh
-	for (auto &position : geometry->positions) {
-		position *= scale;
-	}
-	// copy positions and inidices to MeshCollider
-	sphere.collider->indices = geometry->indices;
-	for (const auto &vertex_pos : geometry->positions) {
-		sphere.collider->positions.push_back(Terathon::Vector3D(vertex_pos.x, vertex_pos.y, vertex_pos.z));
-	}
-
 	return sphere;
 }
 
@@ -135,11 +173,12 @@ std::shared_ptr<std::vector<StaticObject>> create_static_objects(const std::stri
 	auto objects = std::make_shared<std::vector<StaticObject>>();
 	const auto mesh_nodes = ron::gltf::import(gltf_path).get_mesh_nodes();
 
-	for (auto &mesh_node : mesh_nodes) {
+	for (size_t i = 0; i < mesh_nodes.size(); i++) {
+		const auto &mesh_node = mesh_nodes[i];
 		StaticObject static_object {
 			std::make_shared<tics::StaticBody>(),
 			std::make_shared<tics::Transform>(),
-			std::make_shared<tics::MeshCollider>(),
+			load_mesh_collider<tics::TriangleMeshCollider>(gltf_path, i),
 		};
 
 		const auto center = mesh_node->get_model_matrix() * glm::vec4(0,0,0,1);
@@ -149,11 +188,6 @@ std::shared_ptr<std::vector<StaticObject>> create_static_objects(const std::stri
 	static_object.transform->position = Terathon::Vector3D(center.x,center.y,center.z);
 #endif
 
-		const auto ground_geometry = mesh_node->get_mesh()->sections.front().geometry;
-		static_object.collider->indices = ground_geometry->indices;
-		for (const auto &vertex_pos : ground_geometry->positions) {
-			static_object.collider->positions.push_back(Terathon::Vector3D(vertex_pos.x, vertex_pos.y, vertex_pos.z));
-		}
 		static_object.static_body->set_collider(static_object.collider);
 		static_object.static_body->set_transform(static_object.transform);
 
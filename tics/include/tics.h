@@ -5,6 +5,10 @@
 #include <map>
 #include <memory>
 #include <functional>
+#include <limits>
+#include <span>
+#include <string>
+#include <chrono>
 
 #include <TSVector3D.h>
 #include <TSMatrix3D.h>
@@ -30,16 +34,61 @@ struct Transform {
 	#endif
 };
 
+// blends two transforms, alpha 0 returns from and alpha 1 returns to.
+// rotations are normalized linear blends (nlerp), which are close to slerp for the small rotations of a physics step
+Transform interpolate(const Transform &from, const Transform &to, const float alpha);
+
+// writes one column major 4x4 matrix (16 floats, the layout of OpenGL and glm) per transform into matrices,
+// e.g. straight into a buffer for instanced rendering. matrices needs 16 * transforms.size() floats.
+// several transforms are converted at once with SIMD
+void write_transform_matrices(const std::span<const Transform> transforms, const std::span<float> matrices);
+
 enum ColliderType {
 	SPHERE,
 	PLANE,
 	MESH,
+	BOX,
+	SCALED_MESH,
+	TRIANGLE,
+	TRIANGLE_MESH,
+	HEIGHTFIELD,
+	COMPOUND,
 };
 
 struct Collider {
 	ColliderType type;
 };
 
+// axis aligned bounding box
+struct AABB {
+	Terathon::Vector3D min = Terathon::Vector3D(0,0,0);
+	Terathon::Vector3D max = Terathon::Vector3D(0,0,0);
+};
+
+// Node of a bounding volume hierarchy. The nodes are stored depth first in a flat array:
+// the left child of an inner node directly follows its parent, the right child is stored at "right_or_first".
+// leaf nodes contain the primitives primitive_indices[right_or_first, right_or_first + count)
+struct BVHNode {
+	AABB bounds;
+	uint32_t right_or_first = 0;
+	uint32_t count = 0; // 0 for inner nodes
+};
+
+struct BVH {
+	std::vector<BVHNode> nodes = {};
+	std::vector<uint32_t> primitive_indices = {};
+};
+
+// nodes deeper than this (the root has depth 0) become leaves, however many primitives they have.
+// the traversals keep the nodes they still have to visit in a fixed stack: at most bvh_max_depth + 1 entries
+constexpr uint32_t bvh_max_depth = 48;
+
+// builds a bounding volume hierarchy over the given primitive bounds using the surface area heuristic (SAH)
+BVH build_bvh(const std::vector<AABB> &primitive_bounds);
+// recomputes the node bounds of a BVH for moved primitives, keeping its structure. much cheaper than a rebuild,
+// but the tree gets worse the further the primitives moved since it was built
+void refit_bvh(BVH &bvh, const std::vector<AABB> &primitive_bounds);
+
 struct SphereCollider : Collider {
 	SphereCollider() { type = SPHERE; };
 	Terathon::Vector3D center = Terathon::Vector3D(0, 0, 0);
@@ -52,13 +101,120 @@ struct PlaneCollider : Collider {
 	float distance = 0.0f;
 };
 
+// box centered at the origin of its local space
+struct BoxCollider : Collider {
+	BoxCollider() { type = BOX; };
+	Terathon::Vector3D half_extents = Terathon::Vector3D(0.5, 0.5, 0.5);
+};
+
+// one triangle of a cooked mesh collider. everything a raycast needs is in one record,
+// so the raycasts don't have to look up the positions through the indices
+struct CookedTriangle {
+	Terathon::Point3D a;
+	Terathon::Point3D b;
+	Terathon::Point3D c;
+	// the lines through the edges ab, bc and ca (Wedge(a, b), ...), for the Plücker formulation
+	Terathon::Line3D e_ab;
+	Terathon::Line3D e_bc;
+	Terathon::Line3D e_ca;
+	uint32_t triangle_index; // index of the triangle in MeshCollider::indices
+};
+
 struct MeshCollider : Collider {
 	MeshCollider() { type = MESH; };
 	std::vector<Terathon::Vector3D> positions = {};
 	std::vector<uint32_t> indices = {};
-	std::vector<Terathon::Line3D> edges = {};
+	// everything below is built by cook_mesh_collider()
+	// triangle BVH. primitives are triangle indices
+	BVH bvh = {};
+	// one record per triangle, in the order of bvh.primitive_indices -> a leaf's range indexes triangles directly
+	std::vector<CookedTriangle> triangles = {};
+};
+
+// a shared mesh collider with a scale of its own, so bodies of one shape in different sizes share one copy of the geometry.
+// the mesh is never modified through it, the scale is applied by the support function and the raycast.
+// every component of the scale has to be positive
+struct ScaledMeshCollider : Collider {
+	ScaledMeshCollider() { type = SCALED_MESH; };
+	std::shared_ptr<const MeshCollider> mesh = nullptr;
+	Terathon::Vector3D scale = Terathon::Vector3D(1, 1, 1);
+};
+
+// a single flat triangle. triangle mesh colliders are tested one triangle at a time as these
+struct TriangleCollider : Collider {
+	TriangleCollider() { type = TRIANGLE; };
+	Terathon::Vector3D a = Terathon::Vector3D(0, 0, 0);
+	Terathon::Vector3D b = Terathon::Vector3D(1, 0, 0);
+	Terathon::Vector3D c = Terathon::Vector3D(0, 0, 1);
+};
+
+// concave triangle soup for static level geometry, unlike a MeshCollider, which is treated as its convex hull.
+// convex shapes are only tested against the triangles in their bounds, which are found with the triangle BVH
+// if it is cooked (see cook_mesh_collider), otherwise all triangles are tested. a contact is the deepest one of
+// all touched triangles, triangles are solid from both sides. only for static bodies, two of them are never tested.
+// collision areas and world overlap queries with a plane or triangle mesh shape test it triangle by triangle
+struct TriangleMeshCollider : MeshCollider {
+	TriangleMeshCollider() { type = TRIANGLE_MESH; };
 };
 
+// terrain from a grid of heights, for static bodies like triangle meshes, with one float per sample.
+// the sample in column x and row z is at (x * cell_size, heights[z * columns + x], z * cell_size) in local space.
+// every cell between four samples is split into two triangles along the diagonal from (x, z) to (x + 1, z + 1).
+// convex shapes are only tested against the triangles of the cells under their bounds, planes and triangle meshes
+// (of collision areas and world overlap queries) triangle by triangle like against a triangle mesh
+struct HeightfieldCollider : Collider {
+	HeightfieldCollider() { type = HEIGHTFIELD; };
+	uint32_t columns = 0; // samples along x
+	uint32_t rows = 0; // samples along z
+	float cell_size = 1.0f;
+	std::vector<float> heights = {}; // columns * rows, row after row
+	// empty or one flag per cell ((columns - 1) * (rows - 1), row after row). cells with a hole have no triangles
+	std::vector<bool> holes = {};
+	// range of the heights, computed by cook_heightfield_collider()
+	float min_height = 0.0f;
+	float max_height = 0.0f;
+};
+
+// computes the height range of a heightfield. needs to be called again when the heights change
+void cook_heightfield_collider(HeightfieldCollider &heightfield_collider);
+
+// one part of a compound collider
+struct CompoundChild {
+	std::shared_ptr<const Collider> collider = nullptr;
+	Transform transform = {}; // of the child in the local space of the compound
+};
+
+// several convex shapes that move as one body, e.g. the convex parts of a concave body (see convex_decomposition)
+// or an assembly like a cart (a box and four spheres). only the children whose bounds overlap the other shape are
+// tested, they are found with the child BVH. collision_test gives the deepest contact of all children,
+// collision_contacts one per touching child. the children are convex: spheres, meshes, scaled meshes, boxes or triangles
+struct CompoundCollider : Collider {
+	CompoundCollider() { type = COMPOUND; };
+	std::vector<CompoundChild> children = {};
+	// built by cook_compound_collider(). primitives are child indices
+	BVH bvh = {};
+};
+
+// builds the child BVH of a compound collider. needs to be called again when the children change
+void cook_compound_collider(CompoundCollider &compound_collider);
+
+struct ConvexDecompositionSettings {
+	uint32_t resolution = 32; // voxels along the longest side of the mesh
+	// parts are split while the empty space in their convex hull (the voxels outside of the mesh) is larger than
+	// this part of the volume of the whole mesh
+	float max_concavity = 0.02f;
+	uint32_t max_hulls = 16;
+	uint32_t max_hull_vertices = 32;
+};
+
+// splits a concave mesh into convex parts, which is what GJK and EPA need (approximate convex decomposition like V-HACD):
+// the mesh is voxelized, the most concave part is split by axis aligned planes until the convex hull of every part
+// is mostly filled, and the hull of the mesh clipped to every part becomes a cooked mesh collider, centered by its
+// child transform.
+// the mesh should be closed, otherwise only the voxels of its surface are used.
+// this takes a while, decompose once when loading and share the result
+CompoundCollider convex_decomposition(const MeshCollider &mesh_collider, const ConvexDecompositionSettings &settings = {});
+
 struct eafds {
 	std::vector<Terathon::Vector3D> positions = {};
 	std::vector<uint32_t> indices = {};
@@ -75,10 +231,77 @@ static void kdfak() {
 	sizeof(gasfdas);
 }
 
+// needs a cooked collider (see cook_mesh_collider)
 bool pga_raycast(const MeshCollider &mesh_collider, const Terathon::Point3D ray_start, const Terathon::Vector3D direction);
 
 bool raycast(const MeshCollider &mesh_collider, const Terathon::Vector3D ray_start, const Terathon::Vector3D direction);
 
+// builds the triangle BVH and the triangle records (with precomputed edge lines) of a mesh collider.
+// needs to be called again when positions or indices change
+void cook_mesh_collider(MeshCollider &mesh_collider);
+
+// Cooked collider files: a cooked mesh collider (source data, BVH and triangle records) in one flat binary file,
+// which is memory mapped and copied out instead of importing and cooking the source again.
+// source_hash identifies what the collider was made from (e.g. content_hash of the source file and its settings),
+// loading fails for another hash, a broken file (e.g. indices out of range) or a file of another version, so the caller
+// can cook again. mesh_collider is only changed if loading succeeds
+uint64_t content_hash(const std::span<const uint8_t> data, const uint64_t seed = 0xcbf29ce484222325);
+bool save_cooked_mesh_collider(const std::string &path, const MeshCollider &mesh_collider, const uint64_t source_hash);
+bool load_cooked_mesh_collider(const std::string &path, const uint64_t source_hash, MeshCollider &mesh_collider);
+
+struct RaycastHit {
+	float distance; // hit point = ray_start + distance * direction (the actual distance if direction is normalized)
+	uint32_t triangle_index;
+	Terathon::Vector3D normal; // normalized triangle normal
+	Terathon::Vector3D barycentric; // weights of the triangle vertices a, b, c
+	bool has_hit = false;
+};
+
+// finds the closest triangle hit along the ray. only triangles facing the ray are hit.
+// uses the BVH if the collider is cooked, otherwise all triangles are tested
+RaycastHit raycast_closest(
+	const MeshCollider &mesh_collider, const Terathon::Vector3D ray_start, const Terathon::Vector3D direction
+);
+// same for the scaled mesh. the distance is in units of the direction's length like above, the normal is normalized
+RaycastHit raycast_closest(
+	const ScaledMeshCollider &scaled_mesh_collider, const Terathon::Vector3D ray_start, const Terathon::Vector3D direction
+);
+// same for the mesh, scaled mesh and heightfield children of a compound, found with the child BVH if it is cooked.
+// box and sphere children are not hit. triangle_index is the one in the child that was hit
+RaycastHit raycast_closest(
+	const CompoundCollider &compound_collider, const Terathon::Vector3D ray_start, const Terathon::Vector3D direction
+);
+// same for the heightfield. the ray walks through the cells it passes over, front to back, and stops at the first hit.
+// triangle_index is 2 * cell index + 0 or 1
+RaycastHit raycast_closest(
+	const HeightfieldCollider &heightfield_collider, const Terathon::Vector3D ray_start, const Terathon::Vector3D direction
+);
+
+struct Ray {
+	Terathon::Vector3D start = Terathon::Vector3D(0,0,0);
+	Terathon::Vector3D direction = Terathon::Vector3D(0,0,-1);
+	float max_distance = std::numeric_limits<float>::max(); // in units of the direction's length
+};
+
+enum RaycastFormulation {
+	// per ray and triangle: translate the vertices to the ray start, three scalar triple products (see raycast)
+	SCALAR_TRIPLE_PRODUCT,
+	// per triangle: three edge lines, per ray: one line. intersection from their antiwedge products (see pga_raycast).
+	// the edge lines are precomputed by cook_mesh_collider, which makes this the faster one for cooked colliders
+	PLUCKER,
+};
+
+// number of rays that raycast_packet intersects with a triangle at once. 8 with AVX, 4 with SSE, 1 otherwise
+size_t ray_packet_width();
+
+// closest hits (see raycast_closest) of many rays, intersecting ray_packet_width() rays at once with each triangle.
+// works best for coherent rays (e.g. a fan of rays from one origin), because BVH nodes are visited by the whole packet.
+// hits.size() must be >= rays.size()
+void raycast_packet(
+	const MeshCollider &mesh_collider, const std::span<const Ray> rays, const std::span<RaycastHit> hits,
+	const RaycastFormulation formulation = PLUCKER
+);
+
 struct CollisionPoints {
 	// a and b are the points where each shape penetrates the other most
 	// a is the point on shape a that is farthest in shape b
@@ -95,6 +318,38 @@ CollisionPoints collision_test(
 	const Collider& b, const Transform& bt
 );
 
+// like collision_test, but compounds have one contact per child that touches the other shape (per pair of touching
+// children if both are compounds) instead of only the deepest one. the contacts are appended to contacts
+void collision_contacts(
+	const Collider& a, const Transform& at,
+	const Collider& b, const Transform& bt,
+	std::vector<CollisionPoints> &contacts
+);
+
+// true if the colliders overlap. cheaper than collision_test, because no contact information is computed.
+// planes are solid below the plane (dot(normal, p) <= distance in local space). two planes can't be tested
+bool overlap_test(
+	const Collider& a, const Transform& at,
+	const Collider& b, const Transform& bt
+);
+
+struct TimeOfImpact {
+	float fraction; // shape a (almost) touches shape b after moving by fraction * motion, in [0;1]
+	Terathon::Vector3D normal; // surface normal of shape b at the contact, pointing towards shape a
+	Terathon::Vector3D point; // contact point on shape b
+	bool has_hit = false;
+};
+
+// sweeps the convex shape a (sphere, box or mesh, meshes are treated as their convex hull) by motion (translation only)
+// against the convex shape b or the triangles of the triangle mesh or heightfield b.
+// conservative advancement on the GJK distance of the shapes.
+// the shapes stop about 5 mm before they touch. shapes that already overlap hit at fraction 0, shapes closer than that
+// only hit if the motion approaches b
+TimeOfImpact time_of_impact(
+	const Collider& a, const Transform& at, const Terathon::Vector3D& motion,
+	const Collider& b, const Transform& bt
+);
+
 struct Collision;
 
 class ICollisionObject {
@@ -106,6 +361,18 @@ public:
 
 	virtual void set_transform(const std::weak_ptr<Transform> transform) = 0;
 	virtual std::weak_ptr<Transform> get_transform() const = 0;
+	// the transform without locking it, nullptr if it is gone. it must not be destroyed by another thread meanwhile.
+	// for loops over all objects, like snapshots
+	virtual Transform *peek_transform() const { return get_transform().lock().get(); }
+
+	// collision filtering: two objects are only tested against each other if the layer of each one
+	// is in the mask of the other one. pairs that are filtered out never reach the narrowphase
+	uint32_t collision_layer = 1;
+	uint32_t collision_mask = 0xffffffff;
+
+	// assigned by World::add_object in insertion order. pairs and events are ordered by it,
+	// so the simulation doesn't depend on memory addresses
+	uint32_t id = 0;
 };
 
 // A physics body that is not moved by physics simulation. RigidBodies can collide with it.
@@ -117,11 +384,13 @@ public:
 	virtual std::weak_ptr<Collider> get_collider() const override;
 	virtual void set_transform(const std::weak_ptr<Transform> transform) override;
 	virtual std::weak_ptr<Transform> get_transform() const override;
+	virtual Transform *peek_transform() const override;
 
 	float elasticity = 0.8f; // [0;1]
 private:
 	std::weak_ptr<Collider> m_collider;
 	std::weak_ptr<Transform> m_transform;
+	Transform *m_transform_pointer = nullptr; // of m_transform, valid while it hasn't expired
 };
 
 // A physics body that is moved by physics simulation.
@@ -132,6 +401,7 @@ public:
 	virtual std::weak_ptr<Collider> get_collider() const override;
 	virtual void set_transform(const std::weak_ptr<Transform> transform) override;
 	virtual std::weak_ptr<Transform> get_transform() const override;
+	virtual Transform *peek_transform() const override;
 
 	Terathon::Motor3D motor_velocity = Terathon::Motor3D::identity;
 
@@ -149,9 +419,20 @@ public:
 	float mass = 1.0f;
 	float elasticity = 0.9f; // [0;1]
 	float gravity_scale = 1.0f;
+
+	// continuous collision detection: the motion of every step is swept against static bodies,
+	// so small and fast bodies don't tunnel through thin static geometry. only the translation is swept
+	bool continuous_collision_detection = false;
+
+	// the transform before the last World::update, for rendering in between physics steps.
+	// set_transform initializes it, set it as well when teleporting, otherwise the teleport is drawn as a motion
+	Transform previous_transform = {};
+	// alpha is the time since the last update in fixed steps (e.g. the fixed_delay of a game loop / its fixed delta)
+	Transform get_interpolated_transform(const float alpha) const;
 private:
 	std::weak_ptr<Collider> m_collider;
 	std::weak_ptr<Transform> m_transform;
+	Transform *m_transform_pointer = nullptr; // of m_transform, valid while it hasn't expired
 };
 
 // A region that detects other CollisionAreas, RigidBodies and StaticBodies entering or exiting it
@@ -162,18 +443,62 @@ public:
 	virtual std::weak_ptr<Collider> get_collider() const override;
 	virtual void set_transform(const std::weak_ptr<Transform> transform) override;
 	virtual std::weak_ptr<Transform> get_transform() const override;
+	virtual Transform *peek_transform() const override;
 
 	std::function<void(const std::weak_ptr<ICollisionObject> other, CollisionPoints collision_data)> on_collision_enter;
 	std::function<void(const std::weak_ptr<ICollisionObject> other)> on_collision_exit;
+
+	// by default areas are only tested for overlap (see overlap_test), collision_data then only has has_collision set.
+	// set this if on_collision_enter needs the contact points, normal and depth (runs the full collision_test)
+	bool report_contact_data = false;
 private:
 	std::weak_ptr<Collider> m_collider;
 	std::weak_ptr<Transform> m_transform;
+	Transform *m_transform_pointer = nullptr; // of m_transform, valid while it hasn't expired
+};
+
+struct WorldRaycastHit {
+	std::weak_ptr<ICollisionObject> object;
+	Terathon::Vector3D position; // world space
+	Terathon::Vector3D normal; // world space
+	float distance; // position = ray.start + distance * ray.direction
+	uint32_t triangle_index;
+	Terathon::Vector3D barycentric;
+	bool has_hit = false;
+};
+
+struct ShapeCastHit {
+	std::weak_ptr<ICollisionObject> object;
+	Terathon::Vector3D position; // contact point on the hit object, world space
+	Terathon::Vector3D normal; // surface normal of the hit object, pointing towards the cast shape
+	float fraction; // the shape touches the object after moving by fraction * motion
+	bool has_hit = false;
 };
 
 struct Collision {
 	const std::weak_ptr<ICollisionObject> a;
 	const std::weak_ptr<ICollisionObject> b;
 	const CollisionPoints points;
+	// contacts of the pair a, b in this step. a compound has one per touching child, they follow each other in the
+	// collisions. the solvers split the response of a pair between its contacts
+	const uint32_t contact_count = 1;
+};
+
+// one contact of a step in the contact event stream (see World::set_contact_events_enabled).
+// a and b are only handles to identify the objects, they are not kept alive. an object of an end event can be gone
+struct ContactEvent {
+	const ICollisionObject *a;
+	const ICollisionObject *b;
+	CollisionPoints points; // zero for end events
+	Terathon::Vector3D impulse; // applied to a by the ImpulseSolver in this step, b got -impulse. zero if none was applied
+};
+
+// begin and persist have an event per contact, a compound can have several per pair (see Collision::contact_count).
+// end has one event per pair
+struct ContactEvents {
+	std::vector<ContactEvent> begin; // pairs that touch now, but didn't in the previous step
+	std::vector<ContactEvent> persist; // pairs that touched in both steps
+	std::vector<ContactEvent> end; // pairs that touched in the previous step, but not anymore
 };
 
 class ISolver {
@@ -183,6 +508,17 @@ public:
 	virtual void solve(const std::vector<Collision>& collisions, float delta) = 0;
 };
 
+// see World::step
+struct SubStepping {
+	uint32_t min_sub_steps = 1;
+	uint32_t max_sub_steps = 1;
+	// adaptive sub-stepping: if a step with max_sub_steps would take longer than the budget (measured over the
+	// last steps), fewer sub-steps are used, but never less than min_sub_steps. 0 always uses max_sub_steps
+	std::chrono::duration<float> time_budget = std::chrono::duration<float>(0.0f);
+};
+
+class Recorder;
+
 class World {
 public:
 	void add_object(const std::weak_ptr<ICollisionObject> object);
@@ -194,15 +530,132 @@ public:
 	void update(const float delta);
 
 	std::vector<Collision> collision_detection(const float delta);
+	// clears collisions and fills it, so its memory can be reused between steps
+	void collision_detection(const float delta, std::vector<Collision> &collisions);
 	void collision_response(const float delta, const std::vector<Collision> &collisions);
 
+	// a full step: update, collision_detection and collision_response, split into sub-steps of delta / n.
+	// smaller sub-steps keep fast and stacked bodies stable without slowing the game time down.
+	// the broadphase is only refitted between the sub-steps of a step and the collisions reuse one buffer.
+	// contact events are the ones of the last sub-step
+	void step(const float delta);
+	void set_sub_stepping(const SubStepping &sub_stepping);
+	// number of sub-steps of the last step
+	uint32_t get_sub_step_count() const { return m_sub_step_count; }
+
 	void set_gravity(const Terathon::Vector3D gravity);
 	void set_collision_event(const std::function<void(const Collision&)> collision_event);
+	// the contact event stream is an alternative to the collision event for many contacts: when enabled,
+	// collision_response fills the contact events once per step and they can be read until the next step
+	void set_contact_events_enabled(const bool enabled);
+	const ContactEvents &get_contact_events() const;
+
+	// hash of the state of all objects (ids, transforms and rigid body velocities and impulses), bit by bit.
+	// two runs that add the same objects and call the same steps produce the same hashes, so lockstep
+	// simulations and regression tests can compare them per step. see TICS_DETERMINISTIC in CMakeLists.txt
+	uint64_t state_hash() const;
+
+	// Snapshots: the state of all objects (transforms, rigid body velocities and impulses) and of the contact
+	// event stream in a flat, versioned binary buffer. buffer is resized and can be reused between snapshots.
+	// restore writes the state back into the existing objects and returns false (without changing anything)
+	// if the buffer is not from a world with the same objects and the same build (TICS_GA or not)
+	void snapshot(std::vector<uint8_t> &buffer) const;
+	bool restore(const std::span<const uint8_t> buffer);
+
+	// Recording: writes the current state and every following call that changes the world into a file, which
+	// tics::Replay (and the tics_replay tool) can simulate again, e.g. to reproduce a slow frame offline.
+	// changes the game makes to objects between world calls (impulses, velocities, transforms) are recorded too.
+	// only StaticBody, RigidBody and CollisionArea objects and the solvers of tics are recorded,
+	// colliders are recorded once. returns false if the file can't be written.
+	// stop_recording returns false if a later write failed (e.g. the disk is full), the recording ends there
+	bool start_recording(const std::string &path);
+	bool stop_recording();
+
+	// Scene queries. Rays are given in world space and transformed into the local space of each body.
+	// the broadphase is refreshed lazily after update() or adding/removing objects.
+	// call update_broadphase() after moving objects manually.
+	// closest hit of all objects
+	WorldRaycastHit raycast(const Ray &ray);
+	// closest hit of every object that is hit, sorted by distance
+	std::vector<WorldRaycastHit> raycast_all(const Ray &ray);
+	// closest hit per ray, hits.size() must be >= rays.size(). large batches are split across threads
+	void raycast_batch(const std::span<const Ray> rays, const std::span<WorldRaycastHit> hits);
+	// first hit of a convex collider (see time_of_impact) that is moved from transform by motion.
+	// ignore is skipped, e.g. the body that owns the collider. planes are never hit
+	ShapeCastHit shape_cast(
+		const Collider &collider, const Transform &transform, const Terathon::Vector3D &motion,
+		const ICollisionObject *ignore = nullptr
+	);
+
+	// writes all objects that overlap the collider (see overlap_test) to out and returns their number.
+	// if the number is larger than out.size(), only the first out.size() objects were written.
+	// doesn't allocate, except for refreshing the broadphase. ignore is skipped. planes can't be used as the collider
+	size_t overlap(
+		const Collider &collider, const Transform &transform, const std::span<std::weak_ptr<ICollisionObject>> out,
+		const ICollisionObject *ignore = nullptr
+	);
+
+	void update_broadphase();
 private:
+	// moves the bounds of the current broadphase objects, falls back to update_broadphase if any of them is gone
+	void refit_broadphase();
+	bool m_refit_broadphase = false; // set by step for the sub-steps after the first one
+
 	std::vector<std::weak_ptr<ICollisionObject>> m_objects;
+	uint32_t m_next_object_id = 1;
+	// per object of m_objects, in the same order (so sorted by id): what snapshots need without locking or casting
+	// the objects. object is nullptr if the object was already gone when it was added, and must only be used
+	// while the weak_ptr in m_objects hasn't expired
+	struct ObjectEntry {
+		ICollisionObject *object;
+		uint32_t id;
+		uint32_t kind; // see ObjectKind in snapshot.h
+	};
+	std::vector<ObjectEntry> m_object_entries = {};
+	std::shared_ptr<Recorder> m_recorder = nullptr;
+	// broadphase: BVH over the world space bounds of all valid objects
+	// its primitives index into m_broadphase_objects, which are indices into m_objects
+	BVH m_broadphase_bvh = {};
+	std::vector<uint32_t> m_broadphase_objects = {};
+	// objects without finite bounds (planes) would make every BVH node infinitely large, they are kept separately
+	std::vector<uint32_t> m_unbounded_objects = {};
+	std::vector<AABB> m_broadphase_bounds = {}; // world space bounds per primitive
+	bool m_broadphase_dirty = true;
+	// pairs of objects (indices into m_objects) whose bounds overlap and that pass the collision filter.
+	// the first index is the larger one, sorted by the first and then the second index
+	void find_broadphase_pairs(std::vector<std::pair<uint32_t, uint32_t>> &pairs);
+	std::vector<std::pair<uint32_t, uint32_t>> m_broadphase_pairs = {};
+	std::vector<CollisionPoints> m_pair_contacts = {}; // of the pair that is tested, kept to reuse its memory
+
+	void raycast_object(const uint32_t object_index, const Ray &ray, WorldRaycastHit &hit) const;
+	// shape_cast that can be restricted to static bodies which the shape doesn't touch at the start
+	ShapeCastHit sweep(
+		const Collider &collider, const Transform &transform, const Terathon::Vector3D &motion,
+		const ICollisionObject *ignore, const bool static_only
+	);
+	void continuous_collision(RigidBody &rigid_body, const Transform &start, const float delta);
 	std::vector<std::weak_ptr<ISolver>> m_solvers;
+	SubStepping m_sub_stepping = {};
+	uint32_t m_sub_step_count = 1;
+	std::chrono::duration<float> m_sub_step_time = std::chrono::duration<float>(0.0f); // moving average
+	std::vector<Collision> m_step_collisions = {};
 	Terathon::Vector3D m_gravity = Terathon::Vector3D(0.0, -9.81, 0.0);
 	std::function<void(const Collision&)> m_collision_event;
+
+	bool m_contact_events_enabled = false;
+	ContactEvents m_contact_events = {};
+	struct ContactPair {
+		uint32_t id_a, id_b;
+		const ICollisionObject *a, *b;
+		bool operator<(const ContactPair &other) const {
+			return id_a != other.id_a ? id_a < other.id_a : id_b < other.id_b;
+		}
+		bool operator==(const ContactPair &other) const { return id_a == other.id_a && id_b == other.id_b; }
+	};
+	// pairs that touched in the last step, sorted by ids
+	std::vector<ContactPair> m_contact_pairs = {};
+	std::vector<ContactPair> m_previous_contact_pairs = {};
+	void update_contact_events(const std::vector<Collision> &collisions);
 };
 
 class ImpulseSolver : public ISolver {
@@ -210,6 +663,10 @@ public:
 	~ImpulseSolver() {};
 
 	virtual void solve(const std::vector<Collision>& collisions, float delta) override;
+	// impulse that the last solve applied to a, per collision. b got the negative impulse
+	std::span<const Terathon::Vector3D> get_impulses() const { return m_impulses; }
+private:
+	std::vector<Terathon::Vector3D> m_impulses = {};
 };
 
 class NonIntersectionConstraintSolver : public ISolver {
@@ -219,10 +676,20 @@ public:
 	virtual void solve(const std::vector<Collision>& collisions, float delta) override;
 };
 
-struct ObjectAndCollisionData {
+// an object that overlaps a collision area, identified by the ids of both
+struct AreaOverlap {
+	uint32_t area_id;
+	uint32_t object_id;
+	std::weak_ptr<ICollisionObject> area;
 	std::weak_ptr<ICollisionObject> object;
-	CollisionPoints collision_points;
-	bool collision_points_swapped;
+	CollisionPoints collision_points; // seen from the object: a is the point on the object, b the point on the area
+
+	bool operator<(const AreaOverlap &other) const {
+		return area_id != other.area_id ? area_id < other.area_id : object_id < other.object_id;
+	}
+	bool operator==(const AreaOverlap &other) const {
+		return area_id == other.area_id && object_id == other.object_id;
+	}
 };
 
 class CollisionAreaSolver : public ISolver {
@@ -231,10 +698,47 @@ public:
 
 	virtual void solve(const std::vector<Collision>& collisions, float delta) override;
 private:
-	typedef std::map< CollisionArea *, std::vector<ObjectAndCollisionData> >
-		AreasCollisionRecord;
+	// sorted by (area, object), so the overlaps of two frames can be compared in linear time.
+	// both vectors are swapped after every frame, which keeps their memory
+	std::vector<AreaOverlap> m_previous_overlaps = {};
+	std::vector<AreaOverlap> m_current_overlaps = {};
+};
+
+struct ReplayStep {
+	size_t index; // starts at 0 for the first recorded update
+	std::chrono::nanoseconds update;
+	std::chrono::nanoseconds collision_detection;
+	std::chrono::nanoseconds collision_response;
+	size_t collisions; // found by the collision detection of the step
+	bool state_matches; // the state hash after the update equals the recorded one
+};
 
-	AreasCollisionRecord m_areas_collision_record = {};
+// simulates a recording of World::start_recording again, in its own world
+class Replay {
+public:
+	// false if the file is not a recording of this version or of a build with another TICS_GA setting
+	bool open(const std::string &path);
+	World &get_world() { return m_world; }
+	// replays the next recorded update and the calls after it, up to the next update.
+	// returns false at the end of the recording or if the rest of the file is broken
+	bool step(ReplayStep &step);
+private:
+	struct ReplayObject {
+		std::shared_ptr<ICollisionObject> object;
+		std::shared_ptr<Transform> transform;
+	};
+
+	World m_world;
+	std::vector<uint8_t> m_data = {};
+	size_t m_cursor = 0;
+	size_t m_step_count = 0;
+	std::unordered_map<uint32_t, std::shared_ptr<Collider>> m_colliders = {};
+	std::unordered_map<uint32_t, ReplayObject> m_objects = {};
+	std::unordered_map<uint32_t, std::shared_ptr<ISolver>> m_solvers = {};
+	std::vector<Collision> m_collisions = {};
+
+	bool next_is_update() const;
+	bool play_event(ReplayStep &step);
 };
 
 } // tics
@@ -0,0 +1,210 @@
+#include "tics.h"
+#include "geometry.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+using tics::AABB;
+using tics::BVH;
+using tics::BVHNode;
+using tics::MeshCollider;
+using tics::empty_aabb;
+using tics::grow;
+
+// a leaf with this many primitives or less is never split
+static const uint32_t max_leaf_size = 4;
+// number of buckets used to evaluate the SAH per axis (binned SAH)
+static const size_t bin_count = 12;
+
+static float surface_area(const AABB &aabb) {
+	const auto e = aabb.max - aabb.min;
+	if (e.x < 0.0f) { return 0.0f; } // empty
+	return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+}
+
+static uint32_t build_node(
+	BVH &bvh, const std::vector<AABB> &bounds, const std::vector<Terathon::Vector3D> &centroids,
+	const uint32_t first, const uint32_t count, const uint32_t depth
+) {
+	const auto node_index = static_cast<uint32_t>(bvh.nodes.size());
+	bvh.nodes.emplace_back();
+
+	auto node_bounds = empty_aabb();
+	auto centroid_bounds = empty_aabb();
+	for (uint32_t i = first; i < first + count; i++) {
+		grow(node_bounds, bounds[bvh.primitive_indices[i]]);
+		grow(centroid_bounds, centroids[bvh.primitive_indices[i]]);
+	}
+	bvh.nodes[node_index].bounds = node_bounds;
+
+	const auto make_leaf = [&]() {
+		bvh.nodes[node_index].right_or_first = first;
+		bvh.nodes[node_index].count = count;
+		return node_index;
+	};
+
+	if (count <= max_leaf_size || depth == tics::bvh_max_depth) { return make_leaf(); }
+
+	// find the cheapest split: for every axis, sort the centroids into buckets and evaluate a split between buckets
+	// cost = area(left) * count(left) + area(right) * count(right)
+	auto best_cost = std::numeric_limits<float>::max();
+	auto best_axis = -1;
+	size_t best_bin = 0;
+	for (int axis = 0; axis < 3; axis++) {
+		const auto c_min = centroid_bounds.min[axis];
+		const auto c_max = centroid_bounds.max[axis];
+		if (c_max - c_min <= 0.0f) { continue; } // all centroids in one plane
+
+		AABB bin_bounds [bin_count];
+		uint32_t bin_counts [bin_count] = {};
+		for (auto &b : bin_bounds) { b = empty_aabb(); }
+
+		const auto scale = bin_count / (c_max - c_min);
+		for (uint32_t i = first; i < first + count; i++) {
+			const auto primitive = bvh.primitive_indices[i];
+			const auto bin = std::min(bin_count - 1, static_cast<size_t>((centroids[primitive][axis] - c_min) * scale));
+			bin_counts[bin]++;
+			grow(bin_bounds[bin], bounds[primitive]);
+		}
+
+		// sweep from the left and from the right to get the area and count of every split
+		float left_costs [bin_count - 1];
+		auto left_bounds = empty_aabb();
+		uint32_t left_count = 0;
+		for (size_t i = 0; i < bin_count - 1; i++) {
+			grow(left_bounds, bin_bounds[i]);
+			left_count += bin_counts[i];
+			left_costs[i] = surface_area(left_bounds) * left_count;
+		}
+		auto right_bounds = empty_aabb();
+		uint32_t right_count = 0;
+		for (size_t i = bin_count - 1; i > 0; i--) {
+			grow(right_bounds, bin_bounds[i]);
+			right_count += bin_counts[i];
+			const auto cost = left_costs[i - 1] + surface_area(right_bounds) * right_count;
+			if (cost < best_cost) {
+				best_cost = cost;
+				best_axis = axis;
+				best_bin = i;
+			}
+		}
+	}
+
+	// all centroids are at the same position -> splitting does not help
+	if (best_axis == -1) { return make_leaf(); }
+
+	// intersection cost relative to traversal cost: only split if it is cheaper than testing all primitives
+	const auto leaf_cost = surface_area(node_bounds) * count;
+	if (best_cost >= leaf_cost) { return make_leaf(); }
+
+	const auto c_min = centroid_bounds.min[best_axis];
+	const auto scale = bin_count / (centroid_bounds.max[best_axis] - c_min);
+	const auto middle = std::partition(
+		bvh.primitive_indices.begin() + first, bvh.primitive_indices.begin() + first + count,
+		[&](const uint32_t primitive) {
+			const auto bin = std::min(bin_count - 1, static_cast<size_t>((centroids[primitive][best_axis] - c_min) * scale));
+			return bin < best_bin;
+		}
+	);
+	const auto left_count = static_cast<uint32_t>(middle - (bvh.primitive_indices.begin() + first));
+	assert(left_count > 0 && left_count < count);
+
+	build_node(bvh, bounds, centroids, first, left_count, depth + 1);
+	const auto right_index = build_node(bvh, bounds, centroids, first + left_count, count - left_count, depth + 1);
+	// don't keep a reference to the node, emplace_back invalidates it
+	bvh.nodes[node_index].right_or_first = right_index;
+	bvh.nodes[node_index].count = 0;
+
+	return node_index;
+}
+
+BVH tics::build_bvh(const std::vector<AABB> &primitive_bounds) {
+	BVH bvh = {};
+	if (primitive_bounds.empty()) { return bvh; }
+
+	std::vector<Terathon::Vector3D> centroids;
+	centroids.reserve(primitive_bounds.size());
+	for (const auto &b : primitive_bounds) {
+		centroids.push_back((b.min + b.max) * 0.5f);
+	}
+
+	bvh.primitive_indices.resize(primitive_bounds.size());
+	for (uint32_t i = 0; i < primitive_bounds.size(); i++) {
+		bvh.primitive_indices[i] = i;
+	}
+	// a binary tree with n leaves has 2n - 1 nodes
+	bvh.nodes.reserve(2 * primitive_bounds.size());
+
+	build_node(bvh, primitive_bounds, centroids, 0, static_cast<uint32_t>(primitive_bounds.size()), 0);
+
+	return bvh;
+}
+
+void tics::refit_bvh(BVH &bvh, const std::vector<AABB> &primitive_bounds) {
+	// children are stored after their parents, so walking backwards visits the children first
+	for (auto i = bvh.nodes.size(); i-- > 0;) {
+		auto &node = bvh.nodes[i];
+		auto bounds = empty_aabb();
+		if (node.count > 0) {
+			for (uint32_t p = node.right_or_first; p < node.right_or_first + node.count; p++) {
+				grow(bounds, primitive_bounds[bvh.primitive_indices[p]]);
+			}
+		}
+		else {
+			grow(bounds, bvh.nodes[i + 1].bounds);
+			grow(bounds, bvh.nodes[node.right_or_first].bounds);
+		}
+		node.bounds = bounds;
+	}
+}
+
+void tics::cook_mesh_collider(MeshCollider &mesh_collider) {
+	const auto &positions = mesh_collider.positions;
+	const auto &indices = mesh_collider.indices;
+	const auto triangle_count = indices.size() / 3;
+
+	std::vector<AABB> triangle_bounds;
+	triangle_bounds.reserve(triangle_count);
+	for (size_t triangle_index = 0; triangle_index < triangle_count; triangle_index++) {
+		auto bounds = empty_aabb();
+		grow(bounds, positions[indices[triangle_index * 3 + 0]]);
+		grow(bounds, positions[indices[triangle_index * 3 + 1]]);
+		grow(bounds, positions[indices[triangle_index * 3 + 2]]);
+		triangle_bounds.push_back(bounds);
+	}
+
+	mesh_collider.bvh = build_bvh(triangle_bounds);
+
+	// de-indexed triangle records in BVH leaf order, so triangles that are tested together are next to each other
+	mesh_collider.triangles.clear();
+	mesh_collider.triangles.reserve(triangle_count);
+	for (const auto triangle_index : mesh_collider.bvh.primitive_indices) {
+		mesh_collider.triangles.push_back(tics::cook_triangle(
+			positions[indices[triangle_index * 3 + 0]],
+			positions[indices[triangle_index * 3 + 1]],
+			positions[indices[triangle_index * 3 + 2]],
+			triangle_index
+		));
+	}
+}
+
+void tics::cook_heightfield_collider(HeightfieldCollider &heightfield_collider) {
+	assert(heightfield_collider.heights.size() == size_t(heightfield_collider.columns) * heightfield_collider.rows);
+	const auto &heights = heightfield_collider.heights;
+	const auto [min, max] = std::minmax_element(heights.begin(), heights.end());
+	heightfield_collider.min_height = min != heights.end() ? *min : 0.0f;
+	heightfield_collider.max_height = max != heights.end() ? *max : 0.0f;
+}
+
+void tics::cook_compound_collider(CompoundCollider &compound_collider) {
+	std::vector<AABB> child_bounds;
+	child_bounds.reserve(compound_collider.children.size());
+	for (const auto &child : compound_collider.children) {
+		child_bounds.push_back(child.collider
+			? transform_aabb(collider_bounds(*child.collider), child.transform)
+			: empty_aabb()
+		);
+	}
+	compound_collider.bvh = build_bvh(child_bounds);
+}
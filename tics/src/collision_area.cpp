@@ -14,8 +14,13 @@ std::weak_ptr<Collider> CollisionArea::get_collider() const {
 
 void CollisionArea::set_transform(const std::weak_ptr<Transform> transform) {
 	m_transform = transform;
+	m_transform_pointer = transform.lock().get();
 }
 
 std::weak_ptr<Transform> CollisionArea::get_transform() const {
 	return m_transform;
 }
+
+Transform *CollisionArea::peek_transform() const {
+	return m_transform.expired() ? nullptr : m_transform_pointer;
+}
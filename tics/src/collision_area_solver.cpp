@@ -3,83 +3,59 @@
 #include <algorithm>
 
 using tics::CollisionAreaSolver;
+using tics::AreaOverlap;
+
+// calls f for every element of a that is not in b. both are sorted
+template <typename F>
+static void for_each_missing(const std::vector<AreaOverlap> &a, const std::vector<AreaOverlap> &b, F &&f) {
+	auto it_b = b.begin();
+	for (const auto &overlap : a) {
+		while (it_b != b.end() && *it_b < overlap) { it_b++; }
+		if (it_b != b.end() && *it_b == overlap) { continue; }
+		f(overlap);
+	}
+}
 
 void CollisionAreaSolver::solve(const std::vector<Collision>& collisions, float delta) {
-	AreasCollisionRecord current_collisions = {};
+	auto &current = m_current_overlaps;
+	current.clear();
 
 	for (const auto &collision : collisions) {
 		auto sp_a = collision.a.lock();
 		auto sp_b = collision.b.lock();
 		if (!sp_a || !sp_b) { continue; } // are pointers valid?
 
-		const auto area_a = dynamic_cast<CollisionArea *>(sp_a.get());
-		const auto area_b = dynamic_cast<CollisionArea *>(sp_b.get());
-
-		if (area_a) {
-			if (!current_collisions.contains(area_a)) {
-				current_collisions[area_a] = {};
-			}
-			current_collisions[area_a].push_back( ObjectAndCollisionData(sp_b, collision.points, true) );
+		if (dynamic_cast<CollisionArea *>(sp_a.get())) {
+			const auto &points = collision.points;
+			current.push_back({
+				sp_a->id, sp_b->id, sp_a, sp_b,
+				CollisionPoints(points.b, points.a, -points.normal, points.depth, points.has_collision)
+			});
 		}
 
-		if (area_b) {
-			if (!current_collisions.contains(area_b)) {
-				current_collisions[area_b] = {};
-			}
-			current_collisions[area_b].push_back( ObjectAndCollisionData(sp_a, collision.points, false) );
-		}
-	}
-
-	for (const auto &[previous_area, previous_objects] : m_areas_collision_record) {
-		if (!previous_area->on_collision_exit) { continue; } // there is no listener
-
-		for (const auto &prev : previous_objects) {
-			const auto sp_prev = prev.object.lock();
-			if (current_collisions.contains(previous_area) && sp_prev) {
-				const auto &curr_objects = current_collisions[previous_area];
-				auto previous_is_still_colliding = false;
-				for (const auto &curr : curr_objects) {
-					if (!curr.object.expired() && curr.object.lock() == sp_prev) {
-						previous_is_still_colliding = true;
-						continue;
-					}
-				}
-				if (previous_is_still_colliding) { continue; }
-			}
-			// an element that collided previously is not colliding anymore
-			previous_area->on_collision_exit(prev.object);
-		}
-	}
-
-	for (const auto &[current_area, curr_objects] : current_collisions) {
-		if (!current_area->on_collision_enter) { continue; } // there is no listener
-
-		for (const auto &curr : curr_objects) {
-			const auto sp_curr = curr.object.lock();
-			if (m_areas_collision_record.contains(current_area) && sp_curr) {
-				const auto &prev_objects = m_areas_collision_record[current_area];
-				auto current_was_already_colliding = false;
-				for (const auto &prev : prev_objects) {
-					if (!prev.object.expired() && prev.object.lock() == sp_curr) {
-						current_was_already_colliding = true;
-						continue;
-					}
-				}
-				if (current_was_already_colliding) { continue; }
-			}
-			// an element that was not colliding previously is now colliding
-			current_area->on_collision_enter(
-				curr.object,
-				curr.collision_points_swapped
-					? CollisionPoints(
-						curr.collision_points.b, curr.collision_points.a,
-						-curr.collision_points.normal, curr.collision_points.depth,
-						curr.collision_points.has_collision
-					)
-					: curr.collision_points
-			);
+		if (dynamic_cast<CollisionArea *>(sp_b.get())) {
+			current.push_back({ sp_b->id, sp_a->id, sp_b, sp_a, collision.points });
 		}
 	}
 
-	m_areas_collision_record = current_collisions;
+	std::sort(current.begin(), current.end());
+	current.erase(std::unique(current.begin(), current.end()), current.end());
+
+	// an element that collided previously is not colliding anymore
+	for_each_missing(m_previous_overlaps, current, [](const AreaOverlap &overlap) {
+		const auto sp_area = overlap.area.lock();
+		if (!sp_area) { return; } // the area itself is gone
+		const auto &area = static_cast<CollisionArea &>(*sp_area);
+		if (area.on_collision_exit) { area.on_collision_exit(overlap.object); }
+	});
+
+	// an element that was not colliding previously is now colliding
+	for_each_missing(current, m_previous_overlaps, [](const AreaOverlap &overlap) {
+		const auto sp_area = overlap.area.lock();
+		if (!sp_area) { return; }
+		const auto &area = static_cast<CollisionArea &>(*sp_area);
+		if (area.on_collision_enter) { area.on_collision_enter(overlap.object, overlap.collision_points); }
+	});
+
+	std::swap(m_previous_overlaps, m_current_overlaps);
 }
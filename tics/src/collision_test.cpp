@@ -1,6 +1,8 @@
 #include "tics.h"
+#include "geometry.h"
 
 #include <cassert>
+#include <cmath>
 #include <iostream>
 #include <limits>
 #include <algorithm>
@@ -12,6 +14,13 @@ using tics::Collider;
 using tics::SphereCollider;
 using tics::PlaneCollider;
 using tics::MeshCollider;
+using tics::BoxCollider;
+using tics::ScaledMeshCollider;
+using tics::TriangleCollider;
+using tics::TriangleMeshCollider;
+using tics::HeightfieldCollider;
+using tics::CompoundCollider;
+using tics::TimeOfImpact;
 
 struct SupportPoint {
 	Terathon::Vector3D m = Terathon::Vector3D(0,0,0); // minkowski difference
@@ -19,6 +28,24 @@ struct SupportPoint {
 	// Terathon::Vector3D b = Terathon::Vector3D(0,0,0); // on shape b
 };
 
+// the vertex of a mesh furthest in the local direction d
+static Terathon::Vector3D local_support_point_mesh(const MeshCollider &collider, const Terathon::Vector3D &d) {
+	auto support_point_dot = -1.0;
+	auto support_point = Terathon::Vector3D(0,0,0);
+	for (const auto &p : collider.positions) {
+		const auto p_dot_d = Terathon::Dot(p, d);
+		if (p_dot_d > support_point_dot) {
+			support_point_dot = p_dot_d;
+			support_point = p;
+		}
+	}
+
+	// this fails if the center position of a mesh is not inside the mesh
+	assert(support_point_dot >= 0.0);
+
+	return support_point;
+}
+
 // A support function takes a direction d and returns a point on the boundary of a shape "furthest" in direction d
 Terathon::Vector3D support_point_mesh(
 	const Collider &c, const Transform &t, const Terathon::Vector3D &d
@@ -27,41 +54,226 @@ Terathon::Vector3D support_point_mesh(
 
 	const auto &collider = static_cast<const MeshCollider&>(c);
 
+	// find the support point in local space
 	const auto local_d = Terathon::Transform(d, Terathon::Inverse(t.get_rotation()));
+	const auto support_point = local_support_point_mesh(collider, local_d);
 
-	// find the support point in local space
-	auto support_point_dot = -1.0;
-	auto support_point = Terathon::Vector3D(0,0,0);
-	for (const auto &p : collider.positions) {
-		const auto p_dot_d = Terathon::Dot(p, local_d);
-		if (p_dot_d > support_point_dot) {
-			support_point_dot = p_dot_d;
-			support_point = p;
+	return Terathon::Transform(support_point, t.get_rotation()) + t.get_position();
+}
+
+Terathon::Vector3D support_point_scaled_mesh(
+	const Collider &c, const Transform &t, const Terathon::Vector3D &d
+) {
+	assert(c.type == ColliderType::SCALED_MESH);
+
+	const auto &collider = static_cast<const ScaledMeshCollider&>(c);
+	assert(collider.mesh);
+
+	// dot(scale * p, d) = dot(p, scale * d): the vertex furthest in the scaled direction is the support point,
+	// so the shared vertices are scaled on the fly and only the one that is returned
+	const auto local_d = Terathon::Transform(d, Terathon::Inverse(t.get_rotation()));
+	const auto support_point = local_support_point_mesh(*collider.mesh, local_d * collider.scale) * collider.scale;
+
+	return Terathon::Transform(support_point, t.get_rotation()) + t.get_position();
+}
+
+Terathon::Vector3D support_point_box(
+	const Collider &c, const Transform &t, const Terathon::Vector3D &d
+) {
+	assert(c.type == ColliderType::BOX);
+
+	const auto &collider = static_cast<const BoxCollider&>(c);
+
+	// the corner in the octant of the local direction
+	const auto local_d = Terathon::Transform(d, Terathon::Inverse(t.get_rotation()));
+	const auto &h = collider.half_extents;
+	const auto support_point = Terathon::Vector3D(
+		local_d.x < 0.0f ? -h.x : h.x, local_d.y < 0.0f ? -h.y : h.y, local_d.z < 0.0f ? -h.z : h.z
+	);
+
+	return Terathon::Transform(support_point, t.get_rotation()) + t.get_position();
+}
+
+Terathon::Vector3D support_point_triangle(
+	const Collider &c, const Transform &t, const Terathon::Vector3D &d
+) {
+	assert(c.type == ColliderType::TRIANGLE);
+
+	const auto &collider = static_cast<const TriangleCollider&>(c);
+
+	const auto local_d = Terathon::Transform(d, Terathon::Inverse(t.get_rotation()));
+	const auto dot_a = Terathon::Dot(collider.a, local_d);
+	const auto dot_b = Terathon::Dot(collider.b, local_d);
+	const auto dot_c = Terathon::Dot(collider.c, local_d);
+	const auto &support_point = dot_a >= dot_b
+		? (dot_a >= dot_c ? collider.a : collider.c)
+		: (dot_b >= dot_c ? collider.b : collider.c);
+
+	return Terathon::Transform(support_point, t.get_rotation()) + t.get_position();
+}
+
+// support point of a shape with flat faces (mesh, scaled mesh, box or triangle)
+Terathon::Vector3D support_point_polytope(
+	const Collider &c, const Transform &t, const Terathon::Vector3D &d
+) {
+	switch (c.type) {
+		case ColliderType::BOX: return support_point_box(c, t, d);
+		case ColliderType::SCALED_MESH: return support_point_scaled_mesh(c, t, d);
+		case ColliderType::TRIANGLE: return support_point_triangle(c, t, d);
+		default: return support_point_mesh(c, t, d);
+	}
+}
+
+static bool is_polytope(const Collider &c) {
+	return c.type == ColliderType::MESH || c.type == ColliderType::BOX
+		|| c.type == ColliderType::SCALED_MESH || c.type == ColliderType::TRIANGLE;
+}
+
+// triangle meshes and heightfields are tested one triangle at a time
+static bool is_triangle_set(const Collider &c) {
+	return c.type == ColliderType::TRIANGLE_MESH || c.type == ColliderType::HEIGHTFIELD;
+}
+
+// calls f(triangle, transform) for every triangle of a triangle mesh or heightfield with the transform t whose bounds
+// overlap the local space box. the triangles are centered on their centroid and moved there by the transform,
+// so the GJK of two shapes starts with a direction between them
+template <typename F>
+static void for_each_triangle_in_aabb(
+	const Collider &triangles, const Transform &t, const tics::AABB &local_bounds, F &&f
+) {
+	assert(is_triangle_set(triangles));
+
+	const auto visit = [&](const Terathon::Vector3D &a, const Terathon::Vector3D &b, const Terathon::Vector3D &c) {
+		// a BVH leaf or a cell holds several triangles, not all of them overlap the box
+		auto bounds = tics::empty_aabb();
+		tics::grow(bounds, a);
+		tics::grow(bounds, b);
+		tics::grow(bounds, c);
+		if (!tics::overlaps(bounds, local_bounds)) { return; }
+
+		const auto centroid = (a + b + c) / 3.0f;
+		auto triangle = TriangleCollider();
+		triangle.a = a - centroid;
+		triangle.b = b - centroid;
+		triangle.c = c - centroid;
+		f(triangle, tics::translated(t, Terathon::Transform(centroid, t.get_rotation())));
+	};
+
+	if (triangles.type == ColliderType::HEIGHTFIELD) {
+		const auto &heightfield = static_cast<const HeightfieldCollider&>(triangles);
+		if (heightfield.columns < 2 || heightfield.rows < 2) { return; }
+		if (local_bounds.max.y < heightfield.min_height || local_bounds.min.y > heightfield.max_height) { return; }
+
+		// the cells under the box
+		const auto cell_range = [&heightfield](const float min, const float max, const uint32_t samples, uint32_t &first, uint32_t &last) {
+			const auto last_cell = static_cast<float>(samples - 2);
+			const auto first_cell = std::floor(min / heightfield.cell_size);
+			const auto last_touched_cell = std::floor(max / heightfield.cell_size);
+			if (last_touched_cell < 0.0f || first_cell > last_cell) { return false; }
+			first = static_cast<uint32_t>(std::max(first_cell, 0.0f));
+			last = static_cast<uint32_t>(std::min(last_touched_cell, last_cell));
+			return true;
+		};
+		uint32_t x_first, x_last, z_first, z_last;
+		if (!cell_range(local_bounds.min.x, local_bounds.max.x, heightfield.columns, x_first, x_last)) { return; }
+		if (!cell_range(local_bounds.min.z, local_bounds.max.z, heightfield.rows, z_first, z_last)) { return; }
+
+		for (auto z = z_first; z <= z_last; z++) {
+			for (auto x = x_first; x <= x_last; x++) {
+				if (tics::is_hole(heightfield, x, z)) { continue; }
+				for (uint32_t half = 0; half < 2; half++) {
+					Terathon::Vector3D a, b, c;
+					tics::heightfield_triangle(heightfield, x, z, half, a, b, c);
+					visit(a, b, c);
+				}
+			}
 		}
+		return;
 	}
 
-	// this fails if the center position of a mesh is not inside the mesh
-	assert(support_point_dot >= 0.0);
+	const auto &mesh = static_cast<const TriangleMeshCollider&>(triangles);
+	const auto visit_index = [&](const uint32_t triangle_index) {
+		visit(
+			mesh.positions[mesh.indices[triangle_index * 3 + 0]],
+			mesh.positions[mesh.indices[triangle_index * 3 + 1]],
+			mesh.positions[mesh.indices[triangle_index * 3 + 2]]
+		);
+	};
+	if (mesh.bvh.nodes.empty()) {
+		// not cooked -> test all triangles
+		for (uint32_t triangle_index = 0; triangle_index < mesh.indices.size() / 3; triangle_index++) { visit_index(triangle_index); }
+		return;
+	}
+	tics::for_each_primitive_in_aabb(mesh.bvh, local_bounds, visit_index);
+}
 
-	support_point = Terathon::Transform(support_point, t.get_rotation());
-	support_point = support_point + t.get_position();
+// calls f(child, transform) for every child of a compound with the transform t whose bounds overlap the local space box.
+// transform is the world transform of the child
+template <typename F>
+static void for_each_child_in_aabb(
+	const Collider &c, const Transform &t, const tics::AABB &local_bounds, F &&f
+) {
+	assert(c.type == ColliderType::COMPOUND);
 
-	return support_point;
+	const auto &compound = static_cast<const CompoundCollider&>(c);
+	const auto visit = [&](const uint32_t child_index) {
+		const auto &child = compound.children[child_index];
+		if (child.collider) { f(*child.collider, tics::compose(t, child.transform)); }
+	};
+	if (compound.bvh.nodes.empty()) {
+		// not cooked -> test the bounds of all children
+		for (uint32_t child_index = 0; child_index < compound.children.size(); child_index++) {
+			const auto &child = compound.children[child_index];
+			if (!child.collider) { continue; }
+			if (tics::overlaps(tics::transform_aabb(tics::collider_bounds(*child.collider), child.transform), local_bounds)) {
+				visit(child_index);
+			}
+		}
+		return;
+	}
+	tics::for_each_primitive_in_aabb(compound.bvh, local_bounds, visit);
+}
+
+// bounds of the shape a in the local space of the transform tb
+static tics::AABB bounds_in_local_space(const Collider &a, const Transform &ta, const Transform &tb) {
+	return tics::inverse_transform_aabb(tics::transform_aabb(tics::collider_bounds(a), ta), tb);
+}
+
+static Terathon::Vector4D world_plane(const Collider& c, const Transform& t);
+
+// calls f(triangle, transform) like for_each_triangle_in_aabb for all triangles of a triangle mesh or heightfield b,
+// unless its bounds are completely above the plane a. planes are unbounded, so there is no box to find triangles with
+template <typename F>
+static void for_each_triangle_near_plane(
+	const Collider &a, const Transform &ta, const Collider &b, const Transform &tb, F &&f
+) {
+	const auto local_bounds = tics::collider_bounds(b);
+	if (local_bounds.min.x > local_bounds.max.x) { return; }
+	const auto plane = world_plane(a, ta);
+	const auto bounds = tics::transform_aabb(local_bounds, tb);
+	// the corner of the bounds that is deepest below the plane
+	const auto corner = Terathon::Vector3D(
+		plane.x >= 0.0f ? bounds.min.x : bounds.max.x,
+		plane.y >= 0.0f ? bounds.min.y : bounds.max.y,
+		plane.z >= 0.0f ? bounds.min.z : bounds.max.z
+	);
+	if (Terathon::Dot(plane.xyz, corner) > plane.w) { return; }
+	for_each_triangle_in_aabb(b, tb, local_bounds, f);
 }
 
-SupportPoint support_point_on_minkowski_diff_mesh_mesh(
+SupportPoint support_point_on_minkowski_diff_polytope(
 	const Collider &ca, const Transform &ta,
 	const Collider &cb, const Transform &tb,
 	const Terathon::Vector3D &d
 ) {
-	assert(ca.type == ColliderType::MESH);
-	assert(cb.type == ColliderType::MESH);
+	assert(is_polytope(ca));
+	assert(is_polytope(cb));
 
 	auto point = SupportPoint();
-	point.a = support_point_mesh(ca, ta, d);
-	// point.b = support_point_mesh(cb, tb, - d);
+	point.a = support_point_polytope(ca, ta, d);
+	// point.b = support_point_polytope(cb, tb, - d);
 	// point.m = point.a - point.b;
-	point.m = point.a - support_point_mesh(cb, tb, - d);
+	point.m = point.a - support_point_polytope(cb, tb, - d);
 
 	return point;
 }
@@ -84,16 +296,16 @@ void add_if_unique_edge(
 	}
 }
 
-// Mesh vs Mesh collisions use the GJK and EPA Algorithm
-CollisionPoints collision_test_mesh_mesh(
+// Mesh, scaled mesh and box collisions use the GJK and EPA Algorithm (meshes are treated as their convex hull)
+CollisionPoints collision_test_polytope_polytope(
 	const Collider& a, const Transform& ta,
 	const Collider& b, const Transform& tb
 ) {
-	assert(a.type == ColliderType::MESH);
-	assert(b.type == ColliderType::MESH);
+	assert(is_polytope(a));
+	assert(is_polytope(b));
 
-	auto& a_collider = static_cast<const MeshCollider&>(a);
-	auto& b_collider = static_cast<const MeshCollider&>(b);
+	auto& a_collider = a;
+	auto& b_collider = b;
 
 	// GJK Algorithm https://youtu.be/ajv46BSqcK4
 
@@ -102,13 +314,13 @@ CollisionPoints collision_test_mesh_mesh(
 
 	SupportPoint simplex [4] = { SupportPoint(), SupportPoint(), SupportPoint(), SupportPoint() };
 	// find the first support point on the minkowski difference in direction d
-	simplex[0] = support_point_on_minkowski_diff_mesh_mesh(a_collider, ta, b_collider, tb, d);
+	simplex[0] = support_point_on_minkowski_diff_polytope(a_collider, ta, b_collider, tb, d);
 
 	// the next direction is towards the origin
 	d = - simplex[0].m;
 
 	// find the second support point
-	simplex[1] = support_point_on_minkowski_diff_mesh_mesh(a_collider, ta, b_collider, tb, d);
+	simplex[1] = support_point_on_minkowski_diff_polytope(a_collider, ta, b_collider, tb, d);
 	// if the next support point did not "pass" the origin, the shapes do not intersect
 	if (Terathon::Dot(simplex[1].m, d) < 0.001) {
 		return CollisionPoints();
@@ -124,7 +336,7 @@ CollisionPoints collision_test_mesh_mesh(
 	
 	// find the third support point
 	while (true) {
-		simplex[2] = support_point_on_minkowski_diff_mesh_mesh(a_collider, ta, b_collider, tb, d);
+		simplex[2] = support_point_on_minkowski_diff_polytope(a_collider, ta, b_collider, tb, d);
 
 		// if the new support point did not "pass" the origin, the shapes do not intersect
 		if (Terathon::Dot(simplex[2].m, d) < 0.001) {
@@ -177,7 +389,7 @@ CollisionPoints collision_test_mesh_mesh(
 	// only iterate a limited number of times to work around being stuck in a loop
 	for (size_t i = 0; i < 100; i++) {
 	// while (true) {
-		simplex[3] = support_point_on_minkowski_diff_mesh_mesh(a_collider, ta, b_collider, tb, d);
+		simplex[3] = support_point_on_minkowski_diff_polytope(a_collider, ta, b_collider, tb, d);
 
 		const auto fkdasjl = Terathon::Dot(simplex[3].m, d);
 		// if the new support point did not "pass" the origin, the shapes do not intersect
@@ -271,7 +483,7 @@ CollisionPoints collision_test_mesh_mesh(
 			while (true) {
 				// search for a new support point in the direction of the normal of the closest face
 				d = polytope_normals[closest_index].xyz;
-				const auto new_supp_p = support_point_on_minkowski_diff_mesh_mesh(a_collider, ta, b_collider, tb, d);
+				const auto new_supp_p = support_point_on_minkowski_diff_polytope(a_collider, ta, b_collider, tb, d);
 				const auto support_distance = Terathon::Dot(d, new_supp_p.m);
 
 				// check if the support point lies on the same plane as the closest face
@@ -392,6 +604,183 @@ CollisionPoints collision_test_mesh_mesh(
 	return CollisionPoints(); // workaround
 }
 
+struct ClosestPoints {
+	Terathon::Vector3D a; // on shape a
+	Terathon::Vector3D b; // on shape b
+	float distance = 0.0f; // 0 if the core shapes overlap
+	bool overlapping = false;
+};
+
+static ClosestPoints gjk_distance(
+	const Collider &ca, const Transform &ta,
+	const Collider &cb, const Transform &tb
+);
+
+static Terathon::Vector3D sphere_center(const Collider& c, const Transform& t) {
+	const auto &sphere = static_cast<const SphereCollider&>(c);
+	return Terathon::Transform(sphere.center, t.get_rotation()) + t.get_position();
+}
+
+// world space normal and distance of a plane collider
+static Terathon::Vector4D world_plane(const Collider& c, const Transform& t) {
+	const auto &plane = static_cast<const PlaneCollider&>(c);
+	const auto normal = Terathon::Transform(plane.normal, t.get_rotation());
+	return Terathon::Vector4D(normal, Terathon::Dot(normal, t.get_position()) + plane.distance);
+}
+
+// contact of a sphere with the center a_center and the radius a_radius, whose center is distance away from the surface
+// of b in the direction normal
+static CollisionPoints sphere_contact(
+	const Terathon::Vector3D &a_center, const float a_radius, const Terathon::Vector3D &normal, const float distance
+) {
+	auto points = CollisionPoints();
+	points.normal = normal;
+	points.depth = a_radius - distance;
+	points.a = a_center - normal * a_radius;
+	points.b = points.a + normal * points.depth;
+	points.has_collision = true;
+	return points;
+}
+
+CollisionPoints collision_test_sphere_sphere(
+	const Collider& a, const Transform& ta,
+	const Collider& b, const Transform& tb
+) {
+	const auto &sphere_a = static_cast<const SphereCollider&>(a);
+	const auto &sphere_b = static_cast<const SphereCollider&>(b);
+	const auto center_a = sphere_center(a, ta);
+	const auto ba = center_a - sphere_center(b, tb);
+	const auto distance = Terathon::Magnitude(ba);
+	if (distance > sphere_a.radius + sphere_b.radius) { return CollisionPoints(); }
+
+	// concentric spheres have no direction, any one separates them
+	const auto normal = distance > 1e-6f ? ba / distance : Terathon::Vector3D(0,1,0);
+	return sphere_contact(center_a, sphere_a.radius, normal, distance - sphere_b.radius);
+}
+
+// planes are solid below the plane, their normal is the contact normal
+CollisionPoints collision_test_sphere_plane(
+	const Collider& a, const Transform& ta,
+	const Collider& b, const Transform& tb
+) {
+	const auto &sphere = static_cast<const SphereCollider&>(a);
+	const auto center = sphere_center(a, ta);
+	const auto plane = world_plane(b, tb);
+	const auto distance = Terathon::Dot(plane.xyz, center) - plane.w;
+	if (distance > sphere.radius) { return CollisionPoints(); }
+	return sphere_contact(center, sphere.radius, plane.xyz, distance);
+}
+
+// the contact is the deepest point of the polytope below the plane. the normal points from the polytope to the plane
+CollisionPoints collision_test_plane_polytope(
+	const Collider& a, const Transform& ta,
+	const Collider& b, const Transform& tb
+) {
+	assert(a.type == ColliderType::PLANE);
+	assert(is_polytope(b));
+
+	const auto plane = world_plane(a, ta);
+	const auto deepest = support_point_polytope(b, tb, -plane.xyz);
+	const auto depth = plane.w - Terathon::Dot(plane.xyz, deepest);
+	if (depth < 0.0f) { return CollisionPoints(); }
+
+	auto points = CollisionPoints();
+	points.normal = -plane.xyz;
+	points.depth = depth;
+	points.a = deepest + plane.xyz * depth;
+	points.b = deepest;
+	points.has_collision = true;
+	return points;
+}
+
+// while the center of the sphere is outside of the shape, the GJK distance of the center gives the contact.
+// EPA is only needed for deep contacts, it finds how far the center is inside of the shape
+CollisionPoints collision_test_sphere_polytope(
+	const Collider& a, const Transform& ta,
+	const Collider& b, const Transform& tb
+) {
+	assert(a.type == ColliderType::SPHERE);
+	assert(is_polytope(b));
+
+	const auto &sphere = static_cast<const SphereCollider&>(a);
+	const auto closest_points = gjk_distance(a, ta, b, tb);
+	if (!closest_points.overlapping) { return CollisionPoints(); }
+
+	if (closest_points.distance > 1e-4f) {
+		const auto normal = (closest_points.a - closest_points.b) / closest_points.distance;
+		return sphere_contact(closest_points.a, sphere.radius, normal, closest_points.distance);
+	}
+
+	// the center as a polytope: a triangle with three equal corners
+	auto center = TriangleCollider();
+	center.a = sphere.center;
+	center.b = sphere.center;
+	center.c = sphere.center;
+	const auto center_points = collision_test_polytope_polytope(center, ta, b, tb);
+	if (!center_points.has_collision) { return CollisionPoints(); } // the center is on a triangle, there is no direction
+	return sphere_contact(sphere_center(a, ta), sphere.radius, center_points.normal, -center_points.depth);
+}
+
+// the deepest contact of a convex shape with the triangles of a triangle mesh or heightfield
+CollisionPoints collision_test_convex_triangles(
+	const Collider& a, const Transform& ta,
+	const Collider& b, const Transform& tb
+) {
+	assert(is_polytope(a) || a.type == ColliderType::SPHERE);
+
+	auto deepest = CollisionPoints();
+	for_each_triangle_in_aabb(b, tb, bounds_in_local_space(a, ta, tb), [&](const auto &triangle, const auto &t) {
+		const auto points = tics::collision_test(a, ta, triangle, t);
+		if (points.has_collision && (!deepest.has_collision || points.depth > deepest.depth)) { deepest = points; }
+	});
+	return deepest;
+}
+
+// the deepest contact of a plane with the triangles of a triangle mesh or heightfield
+CollisionPoints collision_test_plane_triangles(
+	const Collider& a, const Transform& ta,
+	const Collider& b, const Transform& tb
+) {
+	assert(a.type == ColliderType::PLANE);
+
+	auto deepest = CollisionPoints();
+	for_each_triangle_near_plane(a, ta, b, tb, [&](const auto &triangle, const auto &t) {
+		const auto points = collision_test_plane_polytope(a, ta, triangle, t);
+		if (points.has_collision && (!deepest.has_collision || points.depth > deepest.depth)) { deepest = points; }
+	});
+	return deepest;
+}
+
+// the deepest contact of the triangles of two triangle meshes or heightfields, e.g. of a collision area with level
+// geometry. every triangle of a near b is tested against the triangles of b
+CollisionPoints collision_test_triangle_sets(
+	const Collider& a, const Transform& ta,
+	const Collider& b, const Transform& tb
+) {
+	assert(is_triangle_set(a));
+
+	auto deepest = CollisionPoints();
+	for_each_triangle_in_aabb(a, ta, bounds_in_local_space(b, tb, ta), [&](const auto &triangle, const auto &t) {
+		const auto points = collision_test_convex_triangles(triangle, t, b, tb);
+		if (points.has_collision && (!deepest.has_collision || points.depth > deepest.depth)) { deepest = points; }
+	});
+	return deepest;
+}
+
+// the deepest contact of a shape with the children of a compound whose bounds overlap it.
+// the shape may be a compound itself, its children are then tested against the child of b
+CollisionPoints collision_test_compound(
+	const Collider& a, const Transform& ta,
+	const Collider& b, const Transform& tb
+) {
+	auto deepest = CollisionPoints();
+	for_each_child_in_aabb(b, tb, bounds_in_local_space(a, ta, tb), [&](const Collider &child, const Transform &t) {
+		const auto points = tics::collision_test(a, ta, child, t);
+		if (points.has_collision && (!deepest.has_collision || points.depth > deepest.depth)) { deepest = points; }
+	});
+	return deepest;
+}
+
 // define the function type for a collision test function
 using CollisionTestFunc = CollisionPoints(*)(
 	const Collider&, const Transform&,
@@ -404,11 +793,17 @@ CollisionPoints tics::collision_test(
 ) {
 	// a collision table as described by valve in this pdf on page 33
 	// https://media.steampowered.com/apps/valve/2015/DirkGregorius_Contacts.pdf
-	static const CollisionTestFunc function_table[3][3] = {
-		  // Sphere        Plane           // Mesh
-		{ nullptr,         nullptr,        nullptr                    },  // Sphere
-		{ nullptr,         nullptr       , nullptr                    },  // Plane
-		{ nullptr,         nullptr       , collision_test_mesh_mesh   },  // Mesh
+	static const CollisionTestFunc function_table[9][9] = {
+		  // Sphere                      Plane                         Mesh                               Box                                Scaled mesh                        Triangle                           Triangle mesh                     Heightfield                       Compound
+		{ collision_test_sphere_sphere,  collision_test_sphere_plane,  collision_test_sphere_polytope,    collision_test_sphere_polytope,    collision_test_sphere_polytope,    collision_test_sphere_polytope,    collision_test_convex_triangles,  collision_test_convex_triangles,  collision_test_compound   },  // Sphere
+		{ nullptr,                       nullptr,                      collision_test_plane_polytope,     collision_test_plane_polytope,     collision_test_plane_polytope,     collision_test_plane_polytope,     collision_test_plane_triangles,   collision_test_plane_triangles,   nullptr                   },  // Plane
+		{ nullptr,                       nullptr,                      collision_test_polytope_polytope,  collision_test_polytope_polytope,  collision_test_polytope_polytope,  collision_test_polytope_polytope,  collision_test_convex_triangles,  collision_test_convex_triangles,  collision_test_compound   },  // Mesh
+		{ nullptr,                       nullptr,                      nullptr,                           collision_test_polytope_polytope,  collision_test_polytope_polytope,  collision_test_polytope_polytope,  collision_test_convex_triangles,  collision_test_convex_triangles,  collision_test_compound   },  // Box
+		{ nullptr,                       nullptr,                      nullptr,                           nullptr,                           collision_test_polytope_polytope,  collision_test_polytope_polytope,  collision_test_convex_triangles,  collision_test_convex_triangles,  collision_test_compound   },  // Scaled mesh
+		{ nullptr,                       nullptr,                      nullptr,                           nullptr,                           nullptr,                           collision_test_polytope_polytope,  collision_test_convex_triangles,  collision_test_convex_triangles,  collision_test_compound   },  // Triangle
+		{ nullptr,                       nullptr,                      nullptr,                           nullptr,                           nullptr,                           nullptr,                           collision_test_triangle_sets,     collision_test_triangle_sets,     collision_test_compound   },  // Triangle mesh
+		{ nullptr,                       nullptr,                      nullptr,                           nullptr,                           nullptr,                           nullptr,                           nullptr,                          collision_test_triangle_sets,     collision_test_compound   },  // Heightfield
+		{ nullptr,                       nullptr,                      nullptr,                           nullptr,                           nullptr,                           nullptr,                           nullptr,                          nullptr,                          collision_test_compound   },  // Compound
 	};
 
 	// make sure the colliders are in the correct order
@@ -429,7 +824,442 @@ CollisionPoints tics::collision_test(
 	// if we swapped the input colliders, we need to invert the collision data
 	if (swap) {
 		points.normal = -points.normal;
+		std::swap(points.a, points.b);
 	}
 
 	return points;
 };
+
+void tics::collision_contacts(
+	const Collider& a, const Transform& at,
+	const Collider& b, const Transform& bt,
+	std::vector<CollisionPoints> &contacts
+) {
+	// only the child pairs whose bounds overlap are tested
+	if (b.type == ColliderType::COMPOUND) {
+		for_each_child_in_aabb(b, bt, bounds_in_local_space(a, at, bt), [&](const Collider &child, const Transform &t) {
+			collision_contacts(a, at, child, t, contacts);
+		});
+		return;
+	}
+	if (a.type == ColliderType::COMPOUND) {
+		for_each_child_in_aabb(a, at, bounds_in_local_space(b, bt, at), [&](const Collider &child, const Transform &t) {
+			collision_contacts(child, t, b, bt, contacts);
+		});
+		return;
+	}
+
+	const auto points = collision_test(a, at, b, bt);
+	if (points.has_collision) { contacts.push_back(points); }
+}
+
+// support point of the core shape of a convex collider. meshes are treated as their convex hull.
+// spheres are reduced to their center: GJK converges slowly on curved shapes, so their radius is added afterwards
+static Terathon::Vector3D support_point(const Collider &c, const Transform &t, const Terathon::Vector3D &d) {
+	if (c.type == ColliderType::SPHERE) {
+		const auto &sphere = static_cast<const SphereCollider&>(c);
+		return Terathon::Transform(sphere.center, t.get_rotation()) + t.get_position();
+	}
+	return support_point_polytope(c, t, d);
+}
+
+// distance between the core shape and the surface of a collider
+static float core_radius(const Collider &c) {
+	return c.type == ColliderType::SPHERE ? static_cast<const SphereCollider&>(c).radius : 0.0f;
+}
+
+static SupportPoint support_point_on_minkowski_diff(
+	const Collider &ca, const Transform &ta,
+	const Collider &cb, const Transform &tb,
+	const Terathon::Vector3D &d
+) {
+	auto point = SupportPoint();
+	point.a = support_point(ca, ta, d);
+	point.m = point.a - support_point(cb, tb, - d);
+	return point;
+}
+
+// simplex of the GJK distance algorithm, with the barycentric weights of its point closest to the origin
+struct DistanceSimplex {
+	SupportPoint points [4];
+	float weights [4];
+	size_t size = 0;
+};
+
+static DistanceSimplex make_simplex(
+	const SupportPoint &a, const float w_a,
+	const SupportPoint &b = SupportPoint(), const float w_b = 0.0f,
+	const SupportPoint &c = SupportPoint(), const float w_c = 0.0f,
+	const size_t size = 1
+) {
+	auto simplex = DistanceSimplex();
+	simplex.points[0] = a; simplex.points[1] = b; simplex.points[2] = c;
+	simplex.weights[0] = w_a; simplex.weights[1] = w_b; simplex.weights[2] = w_c;
+	simplex.size = size;
+	return simplex;
+}
+
+static Terathon::Vector3D closest_point(const DistanceSimplex &simplex) {
+	auto v = Terathon::Vector3D(0,0,0);
+	for (size_t i = 0; i < simplex.size; i++) {
+		v += simplex.points[i].m * simplex.weights[i];
+	}
+	return v;
+}
+
+// closest point to the origin on the segment ab, reduced to the vertices that are needed to express it
+static DistanceSimplex closest_on_segment(const SupportPoint &a, const SupportPoint &b) {
+	const auto ab = b.m - a.m;
+	const auto ab_length_sq = Terathon::Dot(ab, ab);
+	if (ab_length_sq == 0.0f) { return make_simplex(a, 1.0f); }
+	const auto t = Terathon::Dot(-a.m, ab) / ab_length_sq;
+	if (t <= 0.0f) { return make_simplex(a, 1.0f); }
+	if (t >= 1.0f) { return make_simplex(b, 1.0f); }
+	return make_simplex(a, 1.0f - t, b, t, SupportPoint(), 0.0f, 2);
+}
+
+// closest point to the origin on the triangle abc, see Real-Time Collision Detection (Ericson) 5.1.5
+static DistanceSimplex closest_on_triangle(const SupportPoint &a, const SupportPoint &b, const SupportPoint &c) {
+	const auto ab = b.m - a.m;
+	const auto ac = c.m - a.m;
+
+	// vertex regions and edge regions, checked with the dot products of the edges and the vectors to the origin
+	const auto d1 = Terathon::Dot(ab, -a.m);
+	const auto d2 = Terathon::Dot(ac, -a.m);
+	if (d1 <= 0.0f && d2 <= 0.0f) { return make_simplex(a, 1.0f); }
+
+	const auto d3 = Terathon::Dot(ab, -b.m);
+	const auto d4 = Terathon::Dot(ac, -b.m);
+	if (d3 >= 0.0f && d4 <= d3) { return make_simplex(b, 1.0f); }
+
+	const auto vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+		const auto t = d1 / (d1 - d3);
+		return make_simplex(a, 1.0f - t, b, t, SupportPoint(), 0.0f, 2);
+	}
+
+	const auto d5 = Terathon::Dot(ab, -c.m);
+	const auto d6 = Terathon::Dot(ac, -c.m);
+	if (d6 >= 0.0f && d5 <= d6) { return make_simplex(c, 1.0f); }
+
+	const auto vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+		const auto t = d2 / (d2 - d6);
+		return make_simplex(a, 1.0f - t, c, t, SupportPoint(), 0.0f, 2);
+	}
+
+	const auto va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+		const auto t = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+		return make_simplex(b, 1.0f - t, c, t, SupportPoint(), 0.0f, 2);
+	}
+
+	// face region
+	const auto sum = va + vb + vc;
+	if (sum == 0.0f) { return closest_on_segment(a, b); } // degenerate triangle
+	const auto v = vb / sum;
+	const auto w = vc / sum;
+	return make_simplex(a, 1.0f - v - w, b, v, c, w, 3);
+}
+
+// reduces the simplex to the smallest sub simplex that contains its point closest to the origin.
+// returns false if the origin is inside the tetrahedron (the shapes overlap)
+static bool reduce_simplex(DistanceSimplex &simplex) {
+	const auto &p = simplex.points;
+	switch (simplex.size) {
+		case 1: simplex.weights[0] = 1.0f; return true;
+		case 2: simplex = closest_on_segment(p[0], p[1]); return true;
+		case 3: simplex = closest_on_triangle(p[0], p[1], p[2]); return true;
+		default: break;
+	}
+
+	// tetrahedron: test every face unless the origin is clearly on its inner side (the side facing the fourth vertex).
+	// faces of flat tetrahedra are always tested
+	const size_t faces [4][4] = { { 0, 1, 2, 3 }, { 0, 2, 3, 1 }, { 0, 3, 1, 2 }, { 1, 3, 2, 0 } };
+	auto best = DistanceSimplex();
+	auto best_distance_sq = std::numeric_limits<float>::max();
+	for (const auto &face : faces) {
+		const auto &a = p[face[0]].m;
+		const auto normal = Terathon::Cross(p[face[1]].m - a, p[face[2]].m - a);
+		const auto origin_side = Terathon::Dot(normal, -a);
+		const auto other_side = Terathon::Dot(normal, p[face[3]].m - a);
+		if (origin_side * other_side > 0.0f) { continue; }
+
+		const auto candidate = closest_on_triangle(p[face[0]], p[face[1]], p[face[2]]);
+		const auto v = closest_point(candidate);
+		const auto distance_sq = Terathon::Dot(v, v);
+		if (distance_sq < best_distance_sq) {
+			best_distance_sq = distance_sq;
+			best = candidate;
+		}
+	}
+	if (best.size == 0) { return false; }
+	simplex = best;
+	return true;
+}
+
+// GJK distance algorithm: iteratively finds the point of the minkowski difference a - b that is closest to the origin
+static ClosestPoints gjk_distance(
+	const Collider &ca, const Transform &ta,
+	const Collider &cb, const Transform &tb
+) {
+	auto closest_points = ClosestPoints();
+
+	auto d = tb.get_position() - ta.get_position();
+	if (Terathon::Dot(d, d) == 0.0f) { d = Terathon::Vector3D(1,0,0); }
+
+	auto simplex = make_simplex(support_point_on_minkowski_diff(ca, ta, cb, tb, d), 1.0f);
+	auto v = simplex.points[0].m;
+
+	for (size_t i = 0; i < 64; i++) {
+		const auto v_length_sq = Terathon::Dot(v, v);
+		if (v_length_sq < 1e-12f) {
+			closest_points.overlapping = true;
+			return closest_points;
+		}
+
+		// if the new support point does not get closer to the origin than v, v is the closest point
+		const auto w = support_point_on_minkowski_diff(ca, ta, cb, tb, -v);
+		if (v_length_sq - Terathon::Dot(v, w.m) <= 1e-6f * v_length_sq) { break; }
+
+		auto new_simplex = simplex;
+		new_simplex.points[new_simplex.size++] = w;
+		if (!reduce_simplex(new_simplex)) {
+			closest_points.overlapping = true;
+			return closest_points;
+		}
+
+		const auto new_v = closest_point(new_simplex);
+		// no progress (numerical precision) -> keep the last result
+		if (Terathon::Dot(new_v, new_v) >= v_length_sq) { break; }
+		simplex = new_simplex;
+		v = new_v;
+	}
+
+	// m = a - b -> the closest point on b is the closest point on a minus v
+	closest_points.a = Terathon::Vector3D(0,0,0);
+	for (size_t i = 0; i < simplex.size; i++) {
+		closest_points.a += simplex.points[i].a * simplex.weights[i];
+	}
+	closest_points.b = closest_points.a - v;
+	closest_points.distance = Terathon::Magnitude(v);
+
+	// move the closest points from the core shapes to the surfaces
+	const auto radius_a = core_radius(ca);
+	const auto radius_b = core_radius(cb);
+	if (closest_points.distance <= radius_a + radius_b) {
+		closest_points.overlapping = true;
+		return closest_points;
+	}
+	const auto normal = v / closest_points.distance;
+	closest_points.a -= normal * radius_a;
+	closest_points.b += normal * radius_b;
+	closest_points.distance -= radius_a + radius_b;
+	return closest_points;
+}
+
+static TimeOfImpact time_of_impact_convex_convex(
+	const Collider& a, const Transform& at, const Terathon::Vector3D& motion,
+	const Collider& b, const Transform& bt
+) {
+	assert(a.type != ColliderType::PLANE && b.type != ColliderType::PLANE);
+
+	// the sweep stops when the gap between the shapes is target_distance +- tolerance.
+	// stopping slightly before the contact keeps GJK well conditioned (the same idea as the TOI of Box2D)
+	const auto target_distance = 0.005f;
+	const auto tolerance = 0.00125f;
+
+	auto toi = TimeOfImpact();
+	// normal and point for shapes that already overlap at the start
+	const auto motion_length = Terathon::Magnitude(motion);
+	toi.normal = motion_length > 0.0f ? -motion / motion_length : Terathon::Vector3D(0,1,0);
+	toi.point = at.get_position();
+	toi.fraction = 0.0f;
+
+	for (size_t i = 0; i < 32; i++) {
+		const auto closest_points = gjk_distance(a, tics::translated(at, motion * toi.fraction), b, bt);
+		if (closest_points.overlapping) {
+			toi.has_hit = true;
+			return toi;
+		}
+
+		toi.normal = (closest_points.a - closest_points.b) / closest_points.distance;
+		toi.point = closest_points.b;
+
+		// shape a only translates, so no point of it approaches b faster than the motion along the normal.
+		// moving by the distance divided by that speed can never pass through b
+		const auto closing_speed = -Terathon::Dot(motion, toi.normal);
+		// moving away, even from a shape that it almost touches
+		if (closing_speed <= 0.0f) { return TimeOfImpact(); }
+
+		if (closest_points.distance <= target_distance + tolerance) {
+			// sliding along b (up to the precision of the normal): the rest of the motion doesn't close the gap
+			if (closing_speed * (1.0f - toi.fraction) <= closest_points.distance) { return TimeOfImpact(); }
+			toi.has_hit = true;
+			return toi;
+		}
+
+		toi.fraction += (closest_points.distance - target_distance) / closing_speed;
+		if (toi.fraction > 1.0f) { return TimeOfImpact(); }
+	}
+
+	// not converged (grazing contact): report the last position, it is still in front of shape b
+	toi.has_hit = true;
+	return toi;
+}
+
+TimeOfImpact tics::time_of_impact(
+	const Collider& a, const Transform& at, const Terathon::Vector3D& motion,
+	const Collider& b, const Transform& bt
+) {
+	assert(!is_triangle_set(a));
+	const auto is_compound = [](const Collider &c) { return c.type == ColliderType::COMPOUND; };
+	if (!is_triangle_set(b) && !is_compound(a) && !is_compound(b)) { return time_of_impact_convex_convex(a, at, motion, b, bt); }
+
+	auto earliest = TimeOfImpact();
+	const auto keep_earliest = [&earliest](const TimeOfImpact &toi) {
+		if (toi.has_hit && (!earliest.has_hit || toi.fraction < earliest.fraction)) { earliest = toi; }
+	};
+
+	// the earliest hit of the children of a, every one is swept on its own
+	if (is_compound(a)) {
+		for (const auto &child : static_cast<const CompoundCollider&>(a).children) {
+			if (child.collider) { keep_earliest(tics::time_of_impact(*child.collider, tics::compose(at, child.transform), motion, b, bt)); }
+		}
+		return earliest;
+	}
+
+	// the earliest hit of the children or triangles of b in the bounds of the whole sweep
+	const auto start_bounds = tics::transform_aabb(tics::collider_bounds(a), at);
+	auto swept_bounds = start_bounds;
+	tics::grow(swept_bounds, tics::AABB(start_bounds.min + motion, start_bounds.max + motion));
+
+	if (is_compound(b)) {
+		for_each_child_in_aabb(b, bt, tics::inverse_transform_aabb(swept_bounds, bt), [&](const Collider &child, const Transform &t) {
+			keep_earliest(tics::time_of_impact(a, at, motion, child, t));
+		});
+		return earliest;
+	}
+	for_each_triangle_in_aabb(b, bt, tics::inverse_transform_aabb(swept_bounds, bt), [&](const auto &triangle, const auto &t) {
+		keep_earliest(time_of_impact_convex_convex(a, at, motion, triangle, t));
+	});
+	return earliest;
+}
+
+// Boolean overlap tests. They are cheaper than the collision tests, because no contact information is computed.
+// planes are solid below the plane: dot(normal, p) <= distance in local space
+
+static bool overlap_test_sphere_sphere(
+	const Collider& a, const Transform& ta,
+	const Collider& b, const Transform& tb
+) {
+	const auto &sphere_a = static_cast<const SphereCollider&>(a);
+	const auto &sphere_b = static_cast<const SphereCollider&>(b);
+	const auto center_a = Terathon::Transform(sphere_a.center, ta.get_rotation()) + ta.get_position();
+	const auto center_b = Terathon::Transform(sphere_b.center, tb.get_rotation()) + tb.get_position();
+	const auto ab = center_b - center_a;
+	const auto radius = sphere_a.radius + sphere_b.radius;
+	return Terathon::Dot(ab, ab) <= radius * radius;
+}
+
+static bool overlap_test_sphere_plane(
+	const Collider& a, const Transform& ta,
+	const Collider& b, const Transform& tb
+) {
+	const auto &sphere = static_cast<const SphereCollider&>(a);
+	const auto center = Terathon::Transform(sphere.center, ta.get_rotation()) + ta.get_position();
+	const auto plane = world_plane(b, tb);
+	return Terathon::Dot(plane.xyz, center) - plane.w <= sphere.radius;
+}
+
+static bool overlap_test_plane_polytope(
+	const Collider& a, const Transform& ta,
+	const Collider& b, const Transform& tb
+) {
+	const auto plane = world_plane(a, ta);
+	// the deepest point of b below the plane
+	const auto p = support_point_polytope(b, tb, -plane.xyz);
+	return Terathon::Dot(plane.xyz, p) <= plane.w;
+}
+
+static bool overlap_test_convex_convex(
+	const Collider& a, const Transform& ta,
+	const Collider& b, const Transform& tb
+) {
+	return gjk_distance(a, ta, b, tb).overlapping;
+}
+
+static bool overlap_test_convex_triangles(
+	const Collider& a, const Transform& ta,
+	const Collider& b, const Transform& tb
+) {
+	auto overlapping = false;
+	for_each_triangle_in_aabb(b, tb, bounds_in_local_space(a, ta, tb), [&](const auto &triangle, const auto &t) {
+		overlapping = overlapping || gjk_distance(a, ta, triangle, t).overlapping;
+	});
+	return overlapping;
+}
+
+static bool overlap_test_plane_triangles(
+	const Collider& a, const Transform& ta,
+	const Collider& b, const Transform& tb
+) {
+	auto overlapping = false;
+	for_each_triangle_near_plane(a, ta, b, tb, [&](const auto &triangle, const auto &t) {
+		overlapping = overlapping || overlap_test_plane_polytope(a, ta, triangle, t);
+	});
+	return overlapping;
+}
+
+static bool overlap_test_triangle_sets(
+	const Collider& a, const Transform& ta,
+	const Collider& b, const Transform& tb
+) {
+	auto overlapping = false;
+	for_each_triangle_in_aabb(a, ta, bounds_in_local_space(b, tb, ta), [&](const auto &triangle, const auto &t) {
+		overlapping = overlapping || overlap_test_convex_triangles(triangle, t, b, tb);
+	});
+	return overlapping;
+}
+
+static bool overlap_test_compound(
+	const Collider& a, const Transform& ta,
+	const Collider& b, const Transform& tb
+) {
+	auto overlapping = false;
+	for_each_child_in_aabb(b, tb, bounds_in_local_space(a, ta, tb), [&](const Collider &child, const Transform &t) {
+		overlapping = overlapping || tics::overlap_test(a, ta, child, t);
+	});
+	return overlapping;
+}
+
+using OverlapTestFunc = bool(*)(
+	const Collider&, const Transform&,
+	const Collider&, const Transform&
+);
+
+bool tics::overlap_test(
+	const Collider& a, const Transform& at,
+	const Collider& b, const Transform& bt
+) {
+	// same layout as the collision table in collision_test
+	static const OverlapTestFunc function_table[9][9] = {
+		  // Sphere                       Plane                       Mesh                          Box                           Scaled mesh                   Triangle                      Triangle mesh                   Heightfield                     Compound
+		{ overlap_test_sphere_sphere,  overlap_test_sphere_plane,  overlap_test_convex_convex,   overlap_test_convex_convex,   overlap_test_convex_convex,   overlap_test_convex_convex,   overlap_test_convex_triangles,  overlap_test_convex_triangles,  overlap_test_compound  },  // Sphere
+		{ nullptr,                     nullptr,                    overlap_test_plane_polytope,  overlap_test_plane_polytope,  overlap_test_plane_polytope,  overlap_test_plane_polytope,  overlap_test_plane_triangles,   overlap_test_plane_triangles,   overlap_test_compound  },  // Plane
+		{ nullptr,                     nullptr,                    overlap_test_convex_convex,   overlap_test_convex_convex,   overlap_test_convex_convex,   overlap_test_convex_convex,   overlap_test_convex_triangles,  overlap_test_convex_triangles,  overlap_test_compound  },  // Mesh
+		{ nullptr,                     nullptr,                    nullptr,                      overlap_test_convex_convex,   overlap_test_convex_convex,   overlap_test_convex_convex,   overlap_test_convex_triangles,  overlap_test_convex_triangles,  overlap_test_compound  },  // Box
+		{ nullptr,                     nullptr,                    nullptr,                      nullptr,                      overlap_test_convex_convex,   overlap_test_convex_convex,   overlap_test_convex_triangles,  overlap_test_convex_triangles,  overlap_test_compound  },  // Scaled mesh
+		{ nullptr,                     nullptr,                    nullptr,                      nullptr,                      nullptr,                      overlap_test_convex_convex,   overlap_test_convex_triangles,  overlap_test_convex_triangles,  overlap_test_compound  },  // Triangle
+		{ nullptr,                     nullptr,                    nullptr,                      nullptr,                      nullptr,                      nullptr,                      overlap_test_triangle_sets,     overlap_test_triangle_sets,     overlap_test_compound  },  // Triangle mesh
+		{ nullptr,                     nullptr,                    nullptr,                      nullptr,                      nullptr,                      nullptr,                      nullptr,                        overlap_test_triangle_sets,     overlap_test_compound  },  // Heightfield
+		{ nullptr,                     nullptr,                    nullptr,                      nullptr,                      nullptr,                      nullptr,                      nullptr,                        nullptr,                        overlap_test_compound  },  // Compound
+	};
+
+	// the tests are symmetric, the order only has to match the table
+	const bool swap = a.type > b.type;
+	const auto overlap_test_function = swap ? function_table[b.type][a.type] : function_table[a.type][b.type];
+	assert(overlap_test_function != nullptr);
+
+	return swap ? overlap_test_function(b, bt, a, at) : overlap_test_function(a, at, b, bt);
+}
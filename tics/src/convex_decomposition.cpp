@@ -0,0 +1,526 @@
+#include "tics.h"
+#include "geometry.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+using tics::CompoundCollider;
+using tics::ConvexDecompositionSettings;
+using tics::MeshCollider;
+
+// Convex hulls (quickhull)
+
+struct HullFace {
+	uint32_t v [3]; // counter clockwise seen from outside
+	Terathon::Vector3D normal;
+	float distance;
+	std::vector<uint32_t> outside = {}; // points in front of the face that aren't on the hull yet
+	bool removed = false;
+};
+
+static float face_distance(const HullFace &face, const Terathon::Vector3D &p) {
+	return Terathon::Dot(face.normal, p) - face.distance;
+}
+
+static HullFace make_face(const std::vector<Terathon::Vector3D> &points, const uint32_t a, const uint32_t b, const uint32_t c) {
+	auto face = HullFace();
+	face.v[0] = a; face.v[1] = b; face.v[2] = c;
+	face.normal = Terathon::Normalize(Terathon::Cross(points[b] - points[a], points[c] - points[a]));
+	face.distance = Terathon::Dot(face.normal, points[a]);
+	return face;
+}
+
+// convex hull of points as triangles with outward counter clockwise corners (indices into points).
+// stops adding vertices when the hull has max_vertices, then the furthest points found so far span it.
+// returns false if the points are (almost) flat
+static bool convex_hull(
+	const std::vector<Terathon::Vector3D> &points, const uint32_t max_vertices, std::vector<uint32_t> &triangles
+) {
+	triangles.clear();
+	if (points.size() < 4) { return false; }
+
+	auto bounds = tics::empty_aabb();
+	for (const auto &p : points) { tics::grow(bounds, p); }
+	const auto extent = bounds.max - bounds.min;
+	const auto epsilon = 1e-5f * std::max<float>({ extent.x, extent.y, extent.z, 1e-6f });
+
+	// initial tetrahedron: the points furthest apart along an axis, the point furthest from their line
+	// and the point furthest from the plane of the three
+	uint32_t extremes [6] = {};
+	for (uint32_t i = 0; i < points.size(); i++) {
+		for (int axis = 0; axis < 3; axis++) {
+			if (points[i][axis] < points[extremes[axis * 2]][axis]) { extremes[axis * 2] = i; }
+			if (points[i][axis] > points[extremes[axis * 2 + 1]][axis]) { extremes[axis * 2 + 1] = i; }
+		}
+	}
+	uint32_t a = 0, b = 0;
+	for (int axis = 0; axis < 3; axis++) {
+		const auto i = extremes[axis * 2], j = extremes[axis * 2 + 1];
+		if (Terathon::SquaredMag(points[j] - points[i]) > Terathon::SquaredMag(points[b] - points[a])) { a = i; b = j; }
+	}
+	if (Terathon::Magnitude(points[b] - points[a]) <= epsilon) { return false; }
+
+	const auto ab = Terathon::Normalize(points[b] - points[a]);
+	uint32_t c = a;
+	auto max_line_distance = 0.0f;
+	for (uint32_t i = 0; i < points.size(); i++) {
+		const auto line_distance = Terathon::Magnitude(Terathon::Cross(points[i] - points[a], ab));
+		if (line_distance > max_line_distance) { max_line_distance = line_distance; c = i; }
+	}
+	if (max_line_distance <= epsilon) { return false; }
+
+	const auto abc_normal = Terathon::Normalize(Terathon::Cross(points[b] - points[a], points[c] - points[a]));
+	uint32_t d = a;
+	auto max_plane_distance = 0.0f;
+	for (uint32_t i = 0; i < points.size(); i++) {
+		const auto plane_distance = std::abs(Terathon::Dot(points[i] - points[a], abc_normal));
+		if (plane_distance > max_plane_distance) { max_plane_distance = plane_distance; d = i; }
+	}
+	if (max_plane_distance <= epsilon) { return false; }
+
+	std::vector<HullFace> faces;
+	// d has to be behind every face
+	if (Terathon::Dot(points[d] - points[a], abc_normal) > 0.0f) { std::swap(b, c); }
+	faces.push_back(make_face(points, a, b, c));
+	faces.push_back(make_face(points, a, d, b));
+	faces.push_back(make_face(points, b, d, c));
+	faces.push_back(make_face(points, c, d, a));
+
+	const auto assign = [&points, &faces, epsilon](const uint32_t point, const size_t first_face) {
+		for (auto f = first_face; f < faces.size(); f++) {
+			if (!faces[f].removed && face_distance(faces[f], points[point]) > epsilon) {
+				faces[f].outside.push_back(point);
+				return;
+			}
+		}
+	};
+	for (uint32_t i = 0; i < points.size(); i++) {
+		if (i != a && i != b && i != c && i != d) { assign(i, 0); }
+	}
+
+	uint32_t vertex_count = 4;
+	std::vector<size_t> visible;
+	std::vector<std::pair<uint32_t, uint32_t>> visible_edges;
+	std::vector<uint32_t> orphans;
+	while (vertex_count < max_vertices) {
+		// the point furthest in front of a face with points in front of it
+		const auto face_it = std::find_if(faces.begin(), faces.end(), [](const auto &face) {
+			return !face.removed && !face.outside.empty();
+		});
+		if (face_it == faces.end()) { break; }
+		const auto eye = *std::max_element(face_it->outside.begin(), face_it->outside.end(), [&](const auto i, const auto j) {
+			return face_distance(*face_it, points[i]) < face_distance(*face_it, points[j]);
+		});
+
+		// the faces the point sees, their edges that aren't shared by two of them are the horizon
+		visible.clear();
+		visible_edges.clear();
+		orphans.clear();
+		for (size_t f = 0; f < faces.size(); f++) {
+			if (faces[f].removed || face_distance(faces[f], points[eye]) <= epsilon) { continue; }
+			visible.push_back(f);
+			for (int e = 0; e < 3; e++) { visible_edges.emplace_back(faces[f].v[e], faces[f].v[(e + 1) % 3]); }
+		}
+		const auto first_new_face = faces.size();
+		for (const auto &[from, to] : visible_edges) {
+			if (std::find(visible_edges.begin(), visible_edges.end(), std::make_pair(to, from)) != visible_edges.end()) { continue; }
+			faces.push_back(make_face(points, from, to, eye));
+		}
+		for (const auto f : visible) {
+			faces[f].removed = true;
+			for (const auto point : faces[f].outside) {
+				if (point != eye) { orphans.push_back(point); }
+			}
+			faces[f].outside.clear();
+		}
+		for (const auto point : orphans) { assign(point, first_new_face); }
+		vertex_count++;
+	}
+
+	for (const auto &face : faces) {
+		if (face.removed) { continue; }
+		triangles.insert(triangles.end(), face.v, face.v + 3);
+	}
+	return true;
+}
+
+// Voxels
+// everything below works in the space of the voxel grid: the voxel (x, y, z) is the unit cube [x, x + 1] x ...
+
+struct Voxel {
+	int32_t x, y, z;
+};
+
+struct VoxelGrid {
+	Terathon::Vector3D origin; // mesh space position of the grid corner
+	float size; // edge length of a voxel in mesh space
+	int32_t dimensions [3];
+	std::vector<uint8_t> cells;
+	// for every row of voxels along x, the number of outside voxels before each x (dimensions[0] + 1 per row)
+	std::vector<uint32_t> outside_before;
+
+	size_t index(const int32_t x, const int32_t y, const int32_t z) const {
+		return (size_t(z) * dimensions[1] + y) * dimensions[0] + x;
+	}
+};
+
+enum VoxelState : uint8_t {
+	VOXEL_UNKNOWN,
+	VOXEL_SURFACE,
+	VOXEL_OUTSIDE,
+};
+
+// separating axis test of a triangle against the voxel with the center c (Akenine-Möller)
+static bool triangle_overlaps_voxel(
+	const Terathon::Vector3D &a, const Terathon::Vector3D &b, const Terathon::Vector3D &c, const Terathon::Vector3D &center
+) {
+	// slightly larger than the voxel, so triangles exactly on a face of it don't fall through the gap
+	const auto h = 0.5f + 1e-4f;
+	const Terathon::Vector3D v [3] = { a - center, b - center, c - center };
+	const auto separated = [&v, h](const Terathon::Vector3D &axis) {
+		const auto p_0 = Terathon::Dot(axis, v[0]), p_1 = Terathon::Dot(axis, v[1]), p_2 = Terathon::Dot(axis, v[2]);
+		const auto r = h * (std::abs(axis.x) + std::abs(axis.y) + std::abs(axis.z));
+		return std::min({ p_0, p_1, p_2 }) > r || std::max({ p_0, p_1, p_2 }) < -r;
+	};
+
+	const Terathon::Vector3D edges [3] = { v[1] - v[0], v[2] - v[1], v[0] - v[2] };
+	const Terathon::Vector3D axes [3] = { Terathon::Vector3D(1,0,0), Terathon::Vector3D(0,1,0), Terathon::Vector3D(0,0,1) };
+	for (const auto &axis : axes) {
+		if (separated(axis)) { return false; }
+		for (const auto &edge : edges) {
+			if (separated(Terathon::Cross(axis, edge))) { return false; }
+		}
+	}
+	return !separated(Terathon::Cross(edges[0], edges[1]));
+}
+
+// marks the voxels touched by the triangles as surface and every voxel that can be reached from the border of the
+// grid without crossing the surface as outside
+static VoxelGrid voxelize(const MeshCollider &mesh, const uint32_t resolution) {
+	auto bounds = tics::empty_aabb();
+	for (const auto &p : mesh.positions) { tics::grow(bounds, p); }
+	const auto extent = bounds.max - bounds.min;
+
+	auto grid = VoxelGrid();
+	grid.size = std::max<float>({ extent.x, extent.y, extent.z }) / static_cast<float>(std::max(resolution, 1u));
+	// one voxel of padding on every side, so the border of the grid is outside of the mesh
+	grid.origin = bounds.min - Terathon::Vector3D(grid.size, grid.size, grid.size);
+	for (int axis = 0; axis < 3; axis++) {
+		grid.dimensions[axis] = static_cast<int32_t>(std::ceil(extent[axis] / grid.size)) + 2;
+	}
+	grid.cells.assign(size_t(grid.dimensions[0]) * grid.dimensions[1] * grid.dimensions[2], VOXEL_UNKNOWN);
+
+	const auto to_grid = [&grid](const Terathon::Vector3D &p) { return (p - grid.origin) / grid.size; };
+	for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+		const auto a = to_grid(mesh.positions[mesh.indices[i + 0]]);
+		const auto b = to_grid(mesh.positions[mesh.indices[i + 1]]);
+		const auto c = to_grid(mesh.positions[mesh.indices[i + 2]]);
+		int32_t first [3], last [3];
+		for (int axis = 0; axis < 3; axis++) {
+			first[axis] = std::clamp(static_cast<int32_t>(std::floor(std::min({ a[axis], b[axis], c[axis] }))), 0, grid.dimensions[axis] - 1);
+			last[axis] = std::clamp(static_cast<int32_t>(std::floor(std::max({ a[axis], b[axis], c[axis] }))), 0, grid.dimensions[axis] - 1);
+		}
+		for (auto z = first[2]; z <= last[2]; z++) {
+			for (auto y = first[1]; y <= last[1]; y++) {
+				for (auto x = first[0]; x <= last[0]; x++) {
+					auto &cell = grid.cells[grid.index(x, y, z)];
+					if (cell == VOXEL_SURFACE) { continue; }
+					if (triangle_overlaps_voxel(a, b, c, Terathon::Vector3D(x + 0.5f, y + 0.5f, z + 0.5f))) { cell = VOXEL_SURFACE; }
+				}
+			}
+		}
+	}
+
+	// flood fill from a corner of the padding
+	std::vector<Voxel> stack = { { 0, 0, 0 } };
+	grid.cells[0] = VOXEL_OUTSIDE;
+	while (!stack.empty()) {
+		const auto voxel = stack.back();
+		stack.pop_back();
+		const Voxel neighbors [6] = {
+			{ voxel.x - 1, voxel.y, voxel.z }, { voxel.x + 1, voxel.y, voxel.z },
+			{ voxel.x, voxel.y - 1, voxel.z }, { voxel.x, voxel.y + 1, voxel.z },
+			{ voxel.x, voxel.y, voxel.z - 1 }, { voxel.x, voxel.y, voxel.z + 1 },
+		};
+		for (const auto &neighbor : neighbors) {
+			if (neighbor.x < 0 || neighbor.y < 0 || neighbor.z < 0) { continue; }
+			if (neighbor.x >= grid.dimensions[0] || neighbor.y >= grid.dimensions[1] || neighbor.z >= grid.dimensions[2]) { continue; }
+			auto &cell = grid.cells[grid.index(neighbor.x, neighbor.y, neighbor.z)];
+			if (cell != VOXEL_UNKNOWN) { continue; }
+			cell = VOXEL_OUTSIDE;
+			stack.push_back(neighbor);
+		}
+	}
+
+	grid.outside_before.resize(size_t(grid.dimensions[1]) * grid.dimensions[2] * (grid.dimensions[0] + 1));
+	for (auto z = 0; z < grid.dimensions[2]; z++) {
+		for (auto y = 0; y < grid.dimensions[1]; y++) {
+			auto *row = &grid.outside_before[(size_t(z) * grid.dimensions[1] + y) * (grid.dimensions[0] + 1)];
+			row[0] = 0;
+			for (auto x = 0; x < grid.dimensions[0]; x++) {
+				row[x + 1] = row[x] + (grid.cells[grid.index(x, y, z)] == VOXEL_OUTSIDE ? 1 : 0);
+			}
+		}
+	}
+	return grid;
+}
+
+// Parts
+
+// a box of the voxel grid with the voxels inside of the mesh in it and the triangles of the mesh that may cross it
+struct Part {
+	int32_t region_min [3];
+	int32_t region_max [3]; // exclusive
+	std::vector<Voxel> voxels = {};
+	std::vector<uint32_t> triangles = {}; // first index of every triangle
+	float concavity = 0.0f;
+};
+
+// the mesh space bounds of the region of a part. the regions at the border of the grid reach into its padding,
+// which is outside of the mesh, so they are unbounded there
+static tics::AABB region_bounds(const VoxelGrid &grid, const int32_t region_min [3], const int32_t region_max [3]) {
+	const auto inf = std::numeric_limits<float>::max();
+	auto bounds = tics::AABB(Terathon::Vector3D(-inf, -inf, -inf), Terathon::Vector3D(inf, inf, inf));
+	for (int axis = 0; axis < 3; axis++) {
+		if (region_min[axis] > 0) { bounds.min[axis] = grid.origin[axis] + region_min[axis] * grid.size; }
+		if (region_max[axis] < grid.dimensions[axis]) { bounds.max[axis] = grid.origin[axis] + region_max[axis] * grid.size; }
+	}
+	return bounds;
+}
+
+static std::vector<uint32_t> triangles_in_region(
+	const MeshCollider &mesh, const std::vector<uint32_t> &triangles, const tics::AABB &region
+) {
+	std::vector<uint32_t> result;
+	for (const auto i : triangles) {
+		auto bounds = tics::empty_aabb();
+		for (int corner = 0; corner < 3; corner++) { tics::grow(bounds, mesh.positions[mesh.indices[i + corner]]); }
+		if (tics::overlaps(bounds, region)) { result.push_back(i); }
+	}
+	return result;
+}
+
+// the part of a polygon on one side of an axis aligned plane (Sutherland-Hodgman)
+static void clip_polygon(
+	std::vector<Terathon::Vector3D> &polygon, const int axis, const float plane, const bool keep_above
+) {
+	std::vector<Terathon::Vector3D> clipped;
+	for (size_t i = 0; i < polygon.size(); i++) {
+		const auto &a = polygon[i];
+		const auto &b = polygon[(i + 1) % polygon.size()];
+		const auto d_a = keep_above ? a[axis] - plane : plane - a[axis];
+		const auto d_b = keep_above ? b[axis] - plane : plane - b[axis];
+		if (d_a >= 0.0f) { clipped.push_back(a); }
+		if ((d_a >= 0.0f) != (d_b >= 0.0f)) { clipped.push_back(a + (b - a) * (d_a / (d_a - d_b))); }
+	}
+	polygon = std::move(clipped);
+}
+
+// the corners of the triangles of a part clipped to its region. for a closed mesh their convex hull is exactly the
+// hull of the solid in the region: the faces cut by the region end on clipped triangles
+static std::vector<Terathon::Vector3D> region_points(const MeshCollider &mesh, const VoxelGrid &grid, const Part &part) {
+	const auto bounds = region_bounds(grid, part.region_min, part.region_max);
+	std::vector<Terathon::Vector3D> points;
+	std::vector<Terathon::Vector3D> polygon;
+	for (const auto i : part.triangles) {
+		polygon = { mesh.positions[mesh.indices[i]], mesh.positions[mesh.indices[i + 1]], mesh.positions[mesh.indices[i + 2]] };
+		for (int axis = 0; axis < 3 && !polygon.empty(); axis++) {
+			clip_polygon(polygon, axis, bounds.min[axis], true);
+			clip_polygon(polygon, axis, bounds.max[axis], false);
+		}
+		points.insert(points.end(), polygon.begin(), polygon.end());
+	}
+	return points;
+}
+
+// volume of the solid in a part, estimated by its voxels. the surface cuts through the surface voxels,
+// about half of them is inside
+static float solid_volume(const VoxelGrid &grid, const std::vector<Voxel> &voxels) {
+	auto volume = 0.0f;
+	for (const auto &v : voxels) { volume += grid.cells[grid.index(v.x, v.y, v.z)] == VOXEL_SURFACE ? 0.5f : 1.0f; }
+	return volume * grid.size * grid.size * grid.size;
+}
+
+// volume of the outside voxels in the region of a part whose center is inside the convex hull of the solid in it,
+// relative to total_volume. the surface voxels are never counted, so a convex part has no concavity at all
+// instead of the error of a voxel volume estimate
+static float concavity(const MeshCollider &mesh, const VoxelGrid &grid, const Part &part, const float total_volume) {
+	const auto points = region_points(mesh, grid, part);
+	std::vector<uint32_t> triangles;
+	if (!convex_hull(points, std::numeric_limits<uint32_t>::max(), triangles)) { return 0.0f; } // flat
+
+	std::vector<Terathon::Vector4D> planes;
+	for (size_t i = 0; i < triangles.size(); i += 3) {
+		const auto &a = points[triangles[i]];
+		const auto normal = Terathon::Normalize(Terathon::Cross(points[triangles[i + 1]] - a, points[triangles[i + 2]] - a));
+		planes.emplace_back(normal, Terathon::Dot(normal, a));
+	}
+
+	// clip every row of voxel centers along x to the hull, then count the outside voxels on the clipped row
+	const auto inside_epsilon = 1e-3f * grid.size;
+	uint32_t count = 0;
+	for (auto z = part.region_min[2]; z < part.region_max[2]; z++) {
+		for (auto y = part.region_min[1]; y < part.region_max[1]; y++) {
+			const auto row_start = grid.origin + Terathon::Vector3D(0.5f * grid.size, (y + 0.5f) * grid.size, (z + 0.5f) * grid.size);
+			// the center of the voxel x is row_start + x * size along x
+			auto first = static_cast<float>(part.region_min[0]);
+			auto last = static_cast<float>(part.region_max[0] - 1);
+			for (const auto &plane : planes) {
+				const auto slope = plane.x * grid.size;
+				const auto offset = Terathon::Dot(plane.xyz, row_start) - plane.w + inside_epsilon;
+				if (std::abs(slope) < 1e-12f) {
+					if (offset > 0.0f) { last = -1.0f; break; } // parallel to the plane and outside of it
+					continue;
+				}
+				if (slope > 0.0f) { last = std::min(last, std::floor(-offset / slope)); }
+				else { first = std::max(first, std::ceil(-offset / slope)); }
+			}
+			if (first > last) { continue; }
+			const auto *row = &grid.outside_before[(size_t(z) * grid.dimensions[1] + y) * (grid.dimensions[0] + 1)];
+			count += row[static_cast<int32_t>(last) + 1] - row[static_cast<int32_t>(first)];
+		}
+	}
+	return count * grid.size * grid.size * grid.size / total_volume;
+}
+
+// splits a part by the best of a few axis aligned planes between its voxels, returns false if it can't be split
+static bool split(
+	const MeshCollider &mesh, const VoxelGrid &grid, const Part &part, const float total_volume, Part &left, Part &right
+) {
+	int32_t voxel_min [3] = { part.region_max[0], part.region_max[1], part.region_max[2] };
+	int32_t voxel_max [3] = { part.region_min[0], part.region_min[1], part.region_min[2] };
+	for (const auto &v : part.voxels) {
+		const int32_t c [3] = { v.x, v.y, v.z };
+		for (int axis = 0; axis < 3; axis++) {
+			voxel_min[axis] = std::min(voxel_min[axis], c[axis]);
+			voxel_max[axis] = std::max(voxel_max[axis], c[axis] + 1);
+		}
+	}
+
+	// about 8 planes per axis, trying every one would take two hulls per plane
+	const auto candidates_per_axis = 8;
+	const auto part_volume = solid_volume(grid, part.voxels);
+	auto best_cost = std::numeric_limits<float>::max();
+	for (int axis = 0; axis < 3; axis++) {
+		const auto step = std::max((voxel_max[axis] - voxel_min[axis]) / candidates_per_axis, 1);
+		for (auto plane = voxel_min[axis] + step; plane < voxel_max[axis]; plane += step) {
+			auto candidate_left = Part(), candidate_right = Part();
+			for (int i = 0; i < 3; i++) {
+				candidate_left.region_min[i] = candidate_right.region_min[i] = part.region_min[i];
+				candidate_left.region_max[i] = candidate_right.region_max[i] = part.region_max[i];
+			}
+			candidate_left.region_max[axis] = plane;
+			candidate_right.region_min[axis] = plane;
+			for (const auto &v : part.voxels) {
+				const int32_t c [3] = { v.x, v.y, v.z };
+				(c[axis] < plane ? candidate_left : candidate_right).voxels.push_back(v);
+			}
+			if (candidate_left.voxels.empty() || candidate_right.voxels.empty()) { continue; }
+
+			for (auto *candidate : { &candidate_left, &candidate_right }) {
+				candidate->triangles = triangles_in_region(
+					mesh, part.triangles, region_bounds(grid, candidate->region_min, candidate->region_max)
+				);
+				candidate->concavity = concavity(mesh, grid, *candidate, total_volume);
+			}
+
+			// prefer planes that split into parts of similar size, otherwise the first splits only shave off thin slices
+			const auto left_volume = solid_volume(grid, candidate_left.voxels);
+			const auto balance = std::abs(left_volume - (part_volume - left_volume)) / total_volume;
+			const auto cost = candidate_left.concavity + candidate_right.concavity + 0.05f * balance;
+			if (cost >= best_cost) { continue; }
+
+			best_cost = cost;
+			left = std::move(candidate_left);
+			right = std::move(candidate_right);
+		}
+	}
+	return best_cost < std::numeric_limits<float>::max();
+}
+
+// the convex hull of the solid in a part as a cooked mesh collider, centered on its vertices
+static std::shared_ptr<MeshCollider> part_hull(
+	const MeshCollider &mesh, const VoxelGrid &grid, const Part &part, const uint32_t max_vertices, Terathon::Vector3D &center
+) {
+	const auto points = region_points(mesh, grid, part);
+	std::vector<uint32_t> triangles;
+	if (!convex_hull(points, std::max(max_vertices, 4u), triangles)) { return nullptr; }
+
+	// keep only the vertices of the hull
+	auto hull = std::make_shared<MeshCollider>();
+	std::vector<uint32_t> remap(points.size(), std::numeric_limits<uint32_t>::max());
+	for (const auto i : triangles) {
+		if (remap[i] == std::numeric_limits<uint32_t>::max()) {
+			remap[i] = static_cast<uint32_t>(hull->positions.size());
+			hull->positions.push_back(points[i]);
+		}
+		hull->indices.push_back(remap[i]);
+	}
+
+	// the support function of a mesh needs its origin inside of it
+	center = Terathon::Vector3D(0,0,0);
+	for (const auto &p : hull->positions) { center += p; }
+	center /= static_cast<float>(hull->positions.size());
+	for (auto &p : hull->positions) { p -= center; }
+	tics::cook_mesh_collider(*hull);
+	return hull;
+}
+
+CompoundCollider tics::convex_decomposition(const MeshCollider &mesh_collider, const ConvexDecompositionSettings &settings) {
+	auto compound = CompoundCollider();
+	if (mesh_collider.positions.empty() || mesh_collider.indices.size() < 3) { return compound; }
+
+	const auto grid = voxelize(mesh_collider, settings.resolution);
+
+	// the voxels inside of the mesh or on its surface
+	auto whole = Part();
+	for (int axis = 0; axis < 3; axis++) {
+		whole.region_min[axis] = 0;
+		whole.region_max[axis] = grid.dimensions[axis];
+	}
+	for (auto z = 0; z < grid.dimensions[2]; z++) {
+		for (auto y = 0; y < grid.dimensions[1]; y++) {
+			for (auto x = 0; x < grid.dimensions[0]; x++) {
+				if (grid.cells[grid.index(x, y, z)] != VOXEL_OUTSIDE) { whole.voxels.push_back({ x, y, z }); }
+			}
+		}
+	}
+	for (uint32_t i = 0; i + 2 < mesh_collider.indices.size(); i += 3) { whole.triangles.push_back(i); }
+	const auto total_volume = std::max(solid_volume(grid, whole.voxels), std::numeric_limits<float>::min());
+	whole.concavity = concavity(mesh_collider, grid, whole, total_volume);
+
+	// always split the most concave part next
+	std::vector<Part> parts;
+	parts.push_back(std::move(whole));
+	while (parts.size() < std::max(settings.max_hulls, 1u)) {
+		const auto worst = std::max_element(parts.begin(), parts.end(), [](const auto &a, const auto &b) {
+			return a.concavity < b.concavity;
+		});
+		if (worst->concavity <= settings.max_concavity) { break; }
+
+		auto left = Part(), right = Part();
+		if (!split(mesh_collider, grid, *worst, total_volume, left, right)) {
+			worst->concavity = 0.0f; // a single voxel wide, nothing to gain
+			continue;
+		}
+		*worst = std::move(left);
+		parts.push_back(std::move(right));
+	}
+
+	for (const auto &part : parts) {
+		auto center = Terathon::Vector3D(0,0,0);
+		const auto hull = part_hull(mesh_collider, grid, part, settings.max_hull_vertices, center);
+		if (!hull) { continue; } // flat, e.g. only touches the mesh at a border of its region
+
+		auto child = CompoundChild();
+		child.collider = hull;
+		child.transform = translated(Transform(), center);
+		compound.children.push_back(std::move(child));
+	}
+	cook_compound_collider(compound);
+	return compound;
+}
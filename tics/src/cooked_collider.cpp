@@ -0,0 +1,300 @@
+#include "tics.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+using tics::MeshCollider;
+
+// layout of a cooked collider file:
+// CookedColliderHeader, positions, indices, BVH nodes, BVH primitive indices, triangle records.
+// positions, nodes and triangles are stored as the flat records below and converted element by element,
+// which doesn't depend on the layout of the Terathon types
+
+static const uint32_t cooked_collider_magic = 0x4d434954; // "TICM"
+static const uint32_t cooked_collider_version = 2;
+
+struct CookedColliderHeader {
+	uint32_t magic;
+	uint32_t version;
+	// sizes of the records, files with other records are rejected
+	uint32_t node_size;
+	uint32_t triangle_size;
+	uint64_t source_hash;
+	uint32_t position_count;
+	uint32_t index_count;
+	uint32_t node_count;
+	uint32_t primitive_index_count;
+	uint32_t triangle_count;
+	uint32_t reserved;
+};
+
+struct PositionRecord {
+	float position [3];
+};
+
+struct NodeRecord {
+	float min [3];
+	float max [3];
+	uint32_t right_or_first;
+	uint32_t count;
+};
+
+struct TriangleRecord {
+	float points [9]; // a, b, c
+	float edges [18]; // e_ab, e_bc, e_ca: direction, then moment
+	uint32_t triangle_index;
+};
+
+static_assert(std::is_trivially_copyable_v<CookedColliderHeader>);
+static_assert(std::is_trivially_copyable_v<PositionRecord>);
+static_assert(std::is_trivially_copyable_v<NodeRecord>);
+static_assert(std::is_trivially_copyable_v<TriangleRecord>);
+
+static PositionRecord to_record(const Terathon::Vector3D &position) {
+	return PositionRecord { { position.x, position.y, position.z } };
+}
+
+static NodeRecord to_record(const tics::BVHNode &node) {
+	const auto &b = node.bounds;
+	return NodeRecord { { b.min.x, b.min.y, b.min.z }, { b.max.x, b.max.y, b.max.z }, node.right_or_first, node.count };
+}
+
+static TriangleRecord to_record(const tics::CookedTriangle &triangle) {
+	auto record = TriangleRecord();
+	auto point = record.points;
+	for (const auto *p : { &triangle.a, &triangle.b, &triangle.c }) {
+		*point++ = p->x; *point++ = p->y; *point++ = p->z;
+	}
+	auto edge = record.edges;
+	for (const auto *e : { &triangle.e_ab, &triangle.e_bc, &triangle.e_ca }) {
+		*edge++ = e->v.x; *edge++ = e->v.y; *edge++ = e->v.z;
+		*edge++ = e->m.x; *edge++ = e->m.y; *edge++ = e->m.z;
+	}
+	record.triangle_index = triangle.triangle_index;
+	return record;
+}
+
+static Terathon::Vector3D from_record(const PositionRecord &record) {
+	return Terathon::Vector3D(record.position[0], record.position[1], record.position[2]);
+}
+
+static tics::BVHNode from_record(const NodeRecord &record) {
+	auto node = tics::BVHNode();
+	node.bounds.min = Terathon::Vector3D(record.min[0], record.min[1], record.min[2]);
+	node.bounds.max = Terathon::Vector3D(record.max[0], record.max[1], record.max[2]);
+	node.right_or_first = record.right_or_first;
+	node.count = record.count;
+	return node;
+}
+
+static tics::CookedTriangle from_record(const TriangleRecord &record) {
+	const auto p = record.points;
+	const auto e = record.edges;
+	auto triangle = tics::CookedTriangle();
+	triangle.a = Terathon::Point3D(p[0], p[1], p[2]);
+	triangle.b = Terathon::Point3D(p[3], p[4], p[5]);
+	triangle.c = Terathon::Point3D(p[6], p[7], p[8]);
+	triangle.e_ab = Terathon::Line3D(e[0], e[1], e[2], e[3], e[4], e[5]);
+	triangle.e_bc = Terathon::Line3D(e[6], e[7], e[8], e[9], e[10], e[11]);
+	triangle.e_ca = Terathon::Line3D(e[12], e[13], e[14], e[15], e[16], e[17]);
+	triangle.triangle_index = record.triangle_index;
+	return triangle;
+}
+
+// whether the indices of a loaded mesh collider are in range, so a broken file can't make queries read out of bounds
+static bool is_valid(const MeshCollider &mesh_collider) {
+	const auto &indices = mesh_collider.indices;
+	const auto &nodes = mesh_collider.bvh.nodes;
+	const auto &primitive_indices = mesh_collider.bvh.primitive_indices;
+	const auto &triangles = mesh_collider.triangles;
+	if (indices.size() % 3 != 0) { return false; }
+	for (const auto index : indices) {
+		if (index >= mesh_collider.positions.size()) { return false; }
+	}
+	const auto triangle_count = indices.size() / 3;
+	for (const auto primitive : primitive_indices) {
+		if (primitive >= triangle_count) { return false; }
+	}
+	// triangle records are in the order of the primitive indices
+	if (!triangles.empty() && triangles.size() != primitive_indices.size()) { return false; }
+	for (size_t i = 0; i < triangles.size(); i++) {
+		if (triangles[i].triangle_index != primitive_indices[i]) { return false; }
+	}
+
+	// children are stored after their parents, so the depths are final when a node is reached
+	auto depths = std::vector<uint32_t>(nodes.size(), 0);
+	for (size_t i = 0; i < nodes.size(); i++) {
+		const auto &node = nodes[i];
+		if (depths[i] > tics::bvh_max_depth) { return false; }
+		if (node.count > 0) {
+			if (node.right_or_first > primitive_indices.size() || node.count > primitive_indices.size() - node.right_or_first) { return false; }
+			continue;
+		}
+		if (i + 1 >= nodes.size() || node.right_or_first <= i + 1 || node.right_or_first >= nodes.size()) { return false; }
+		depths[i + 1] = std::max(depths[i + 1], depths[i] + 1);
+		depths[node.right_or_first] = std::max(depths[node.right_or_first], depths[i] + 1);
+	}
+	return true;
+}
+
+// read only view of a whole file, empty if it can't be mapped
+class MappedFile {
+public:
+	MappedFile(const std::string &path) {
+		#ifdef _WIN32
+			m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0, nullptr);
+			if (m_file == INVALID_HANDLE_VALUE) { return; }
+			LARGE_INTEGER size;
+			if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) { return; }
+			m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (!m_mapping) { return; }
+			const auto view = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+			if (!view) { return; }
+			m_data = static_cast<const uint8_t *>(view);
+			m_size = static_cast<size_t>(size.QuadPart);
+		#else
+			m_file = open(path.c_str(), O_RDONLY);
+			if (m_file < 0) { return; }
+			struct stat status;
+			if (fstat(m_file, &status) != 0 || status.st_size == 0) { return; }
+			const auto view = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+			if (view == MAP_FAILED) { return; }
+			m_data = static_cast<const uint8_t *>(view);
+			m_size = static_cast<size_t>(status.st_size);
+		#endif
+	}
+	~MappedFile() {
+		#ifdef _WIN32
+			if (m_data) { UnmapViewOfFile(m_data); }
+			if (m_mapping) { CloseHandle(m_mapping); }
+			if (m_file != INVALID_HANDLE_VALUE) { CloseHandle(m_file); }
+		#else
+			if (m_data) { munmap(const_cast<uint8_t *>(m_data), m_size); }
+			if (m_file >= 0) { close(m_file); }
+		#endif
+	}
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	const uint8_t *data() const { return m_data; }
+	size_t size() const { return m_size; }
+private:
+	#ifdef _WIN32
+		HANDLE m_file = INVALID_HANDLE_VALUE;
+		HANDLE m_mapping = nullptr;
+	#else
+		int m_file = -1;
+	#endif
+	const uint8_t *m_data = nullptr;
+	size_t m_size = 0;
+};
+
+uint64_t tics::content_hash(const std::span<const uint8_t> data, const uint64_t seed) {
+	// FNV-1a
+	auto hash = seed;
+	for (const auto byte : data) {
+		hash ^= byte;
+		hash *= 0x100000001b3;
+	}
+	return hash;
+}
+
+bool tics::save_cooked_mesh_collider(const std::string &path, const MeshCollider &mesh_collider, const uint64_t source_hash) {
+	const auto header = CookedColliderHeader {
+		cooked_collider_magic, cooked_collider_version,
+		static_cast<uint32_t>(sizeof(NodeRecord)), static_cast<uint32_t>(sizeof(TriangleRecord)),
+		source_hash,
+		static_cast<uint32_t>(mesh_collider.positions.size()),
+		static_cast<uint32_t>(mesh_collider.indices.size()),
+		static_cast<uint32_t>(mesh_collider.bvh.nodes.size()),
+		static_cast<uint32_t>(mesh_collider.bvh.primitive_indices.size()),
+		static_cast<uint32_t>(mesh_collider.triangles.size()),
+		0
+	};
+
+	// written next to the destination and renamed at the end, so readers never see a partial file
+	const auto temporary_path = path + ".tmp";
+	{
+		std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+		if (!file) { return false; }
+		const auto write_indices = [&file](const std::vector<uint32_t> &indices) {
+			file.write(reinterpret_cast<const char *>(indices.data()), indices.size() * sizeof(uint32_t));
+		};
+		const auto write_records = [&file](const auto &items) {
+			for (const auto &item : items) {
+				const auto record = to_record(item);
+				file.write(reinterpret_cast<const char *>(&record), sizeof(record));
+			}
+		};
+		file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+		write_records(mesh_collider.positions);
+		write_indices(mesh_collider.indices);
+		write_records(mesh_collider.bvh.nodes);
+		write_indices(mesh_collider.bvh.primitive_indices);
+		write_records(mesh_collider.triangles);
+		if (!file.good()) { return false; }
+	}
+
+	auto error = std::error_code();
+	std::filesystem::rename(temporary_path, path, error);
+	return !error;
+}
+
+bool tics::load_cooked_mesh_collider(const std::string &path, const uint64_t source_hash, MeshCollider &mesh_collider) {
+	const auto file = MappedFile(path);
+	if (file.size() < sizeof(CookedColliderHeader)) { return false; }
+
+	auto header = CookedColliderHeader();
+	std::memcpy(&header, file.data(), sizeof(header));
+	if (header.magic != cooked_collider_magic || header.version != cooked_collider_version) { return false; }
+	if (header.node_size != sizeof(NodeRecord) || header.triangle_size != sizeof(TriangleRecord)) { return false; }
+	if (header.source_hash != source_hash) { return false; }
+	const auto size = sizeof(header)
+		+ size_t(header.position_count) * sizeof(PositionRecord)
+		+ size_t(header.index_count) * sizeof(uint32_t)
+		+ size_t(header.node_count) * sizeof(NodeRecord)
+		+ size_t(header.primitive_index_count) * sizeof(uint32_t)
+		+ size_t(header.triangle_count) * sizeof(TriangleRecord);
+	if (file.size() != size) { return false; }
+
+	auto offset = sizeof(header);
+	const auto read_indices = [&file, &offset](std::vector<uint32_t> &indices, const uint32_t count) {
+		indices.resize(count);
+		std::memcpy(indices.data(), file.data() + offset, count * sizeof(uint32_t));
+		offset += count * sizeof(uint32_t);
+	};
+	// the mapping is only aligned for the header, so records are copied out before they are converted
+	const auto read_records = [&file, &offset]<typename Record>(auto &items, const uint32_t count, Record record) {
+		items.clear();
+		items.reserve(count);
+		for (uint32_t i = 0; i < count; i++) {
+			std::memcpy(&record, file.data() + offset, sizeof(record));
+			items.push_back(from_record(record));
+			offset += sizeof(record);
+		}
+	};
+	// loaded aside, so mesh_collider is left untouched if the file turns out to be broken
+	auto loaded = MeshCollider();
+	read_records(loaded.positions, header.position_count, PositionRecord());
+	read_indices(loaded.indices, header.index_count);
+	read_records(loaded.bvh.nodes, header.node_count, NodeRecord());
+	read_indices(loaded.bvh.primitive_indices, header.primitive_index_count);
+	read_records(loaded.triangles, header.triangle_count, TriangleRecord());
+	if (!is_valid(loaded)) { return false; }
+	mesh_collider = std::move(loaded);
+	return true;
+}
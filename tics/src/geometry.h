@@ -0,0 +1,198 @@
+#pragma once
+
+// small geometry helpers shared by the tics source files
+
+#include "tics.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace tics {
+
+inline AABB empty_aabb() {
+	const auto inf = std::numeric_limits<float>::max();
+	return AABB(Terathon::Vector3D(inf, inf, inf), Terathon::Vector3D(-inf, -inf, -inf));
+}
+
+inline void grow(AABB &aabb, const Terathon::Vector3D &p) {
+	aabb.min = Terathon::Vector3D(std::min(aabb.min.x, p.x), std::min(aabb.min.y, p.y), std::min(aabb.min.z, p.z));
+	aabb.max = Terathon::Vector3D(std::max(aabb.max.x, p.x), std::max(aabb.max.y, p.y), std::max(aabb.max.z, p.z));
+}
+
+inline void grow(AABB &aabb, const AABB &other) {
+	if (other.min.x > other.max.x) { return; } // empty, its min and max would spread aabb to infinity
+	grow(aabb, other.min);
+	grow(aabb, other.max);
+}
+
+inline bool overlaps(const AABB &a, const AABB &b) {
+	return a.min.x <= b.max.x && a.max.x >= b.min.x
+		&& a.min.y <= b.max.y && a.max.y >= b.min.y
+		&& a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+// slab test, returns the distance at which the ray enters the box or -1 if it misses it
+inline float intersect_ray_aabb(
+	const AABB &aabb, const Terathon::Vector3D &p, const Terathon::Vector3D &inv_v, const float max_distance
+) {
+	const auto t_0 = Terathon::Vector3D(
+		(aabb.min.x - p.x) * inv_v.x, (aabb.min.y - p.y) * inv_v.y, (aabb.min.z - p.z) * inv_v.z
+	);
+	const auto t_1 = Terathon::Vector3D(
+		(aabb.max.x - p.x) * inv_v.x, (aabb.max.y - p.y) * inv_v.y, (aabb.max.z - p.z) * inv_v.z
+	);
+	const auto t_enter = std::max<float>({ std::min(t_0.x, t_1.x), std::min(t_0.y, t_1.y), std::min(t_0.z, t_1.z), 0.0f });
+	const auto t_exit = std::min<float>({ std::max(t_0.x, t_1.x), std::max(t_0.y, t_1.y), std::max(t_0.z, t_1.z), max_distance });
+	return t_enter <= t_exit ? t_enter : -1.0f;
+}
+
+// bounds of a local space box after it was moved by a transform
+inline AABB transform_aabb(const AABB &aabb, const Transform &transform) {
+	const auto center = (aabb.min + aabb.max) * 0.5f;
+	const auto extent = (aabb.max - aabb.min) * 0.5f;
+	const auto r = transform.get_rotation().GetRotationMatrix();
+
+	const auto world_center = Terathon::Transform(center, transform.get_rotation()) + transform.get_position();
+	const auto world_extent = Terathon::Vector3D(
+		std::abs(r(0,0)) * extent.x + std::abs(r(0,1)) * extent.y + std::abs(r(0,2)) * extent.z,
+		std::abs(r(1,0)) * extent.x + std::abs(r(1,1)) * extent.y + std::abs(r(1,2)) * extent.z,
+		std::abs(r(2,0)) * extent.x + std::abs(r(2,1)) * extent.y + std::abs(r(2,2)) * extent.z
+	);
+	return AABB(world_center - world_extent, world_center + world_extent);
+}
+
+// copy of a transform that is moved by offset (in world space)
+inline Transform translated(const Transform &transform, const Terathon::Vector3D &offset) {
+	auto result = transform;
+	#ifdef TICS_GA
+		result.motor = Terathon::Motor3D::MakeTranslation(offset) * transform.motor;
+	#else
+		result.position += offset;
+	#endif
+	return result;
+}
+
+// transform of a child (e.g. of a compound) in the local space of parent -> world transform of the child
+inline Transform compose(const Transform &parent, const Transform &child) {
+	auto result = Transform();
+	#ifdef TICS_GA
+		result.motor = parent.motor * child.motor;
+	#else
+		result.position = parent.position + Terathon::Transform(child.position, parent.rotation);
+		result.rotation = parent.rotation * child.rotation;
+	#endif
+	return result;
+}
+
+// bounds in the local space of a transform of a world space box
+inline AABB inverse_transform_aabb(const AABB &aabb, const Transform &transform) {
+	const auto center = (aabb.min + aabb.max) * 0.5f;
+	const auto extent = (aabb.max - aabb.min) * 0.5f;
+	const auto inv_rotation = Terathon::Inverse(transform.get_rotation());
+	const auto r = inv_rotation.GetRotationMatrix();
+
+	const auto local_center = Terathon::Transform(center - transform.get_position(), inv_rotation);
+	const auto local_extent = Terathon::Vector3D(
+		std::abs(r(0,0)) * extent.x + std::abs(r(0,1)) * extent.y + std::abs(r(0,2)) * extent.z,
+		std::abs(r(1,0)) * extent.x + std::abs(r(1,1)) * extent.y + std::abs(r(1,2)) * extent.z,
+		std::abs(r(2,0)) * extent.x + std::abs(r(2,1)) * extent.y + std::abs(r(2,2)) * extent.z
+	);
+	return AABB(local_center - local_extent, local_center + local_extent);
+}
+
+// local space bounds of a collider. planes are unbounded
+AABB collider_bounds(const Collider &collider);
+
+// calls f(primitive_index) for every BVH leaf primitive whose bounds overlap the box
+template <typename F>
+void for_each_primitive_in_aabb(const BVH &bvh, const AABB &aabb, F &&f) {
+	if (bvh.nodes.empty()) { return; }
+
+	uint32_t stack [bvh_max_depth + 1];
+	size_t stack_size = 0;
+	stack[stack_size++] = 0;
+
+	while (stack_size > 0) {
+		const auto &node = bvh.nodes[stack[--stack_size]];
+		if (!overlaps(node.bounds, aabb)) { continue; }
+
+		if (node.count > 0) {
+			for (uint32_t i = node.right_or_first; i < node.right_or_first + node.count; i++) {
+				f(bvh.primitive_indices[i]);
+			}
+			continue;
+		}
+
+		assert(stack_size + 2 <= std::size(stack));
+		stack[stack_size++] = node.right_or_first;
+		stack[stack_size++] = static_cast<uint32_t>(&node - bvh.nodes.data()) + 1;
+	}
+}
+
+// calls f(primitive_index, max_distance) for every BVH leaf primitive whose bounds are hit by the ray.
+// f returns the new max distance, so closest hit queries can skip nodes behind the current hit
+template <typename F>
+void for_each_primitive_on_ray(const BVH &bvh, const Ray &ray, F &&f) {
+	if (bvh.nodes.empty()) { return; }
+
+	const auto inv_v = Terathon::Vector3D(1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z);
+	auto max_distance = ray.max_distance;
+
+	uint32_t stack [bvh_max_depth + 1];
+	size_t stack_size = 0;
+	stack[stack_size++] = 0;
+
+	while (stack_size > 0) {
+		const auto &node = bvh.nodes[stack[--stack_size]];
+		if (intersect_ray_aabb(node.bounds, ray.start, inv_v, max_distance) < 0.0f) { continue; }
+
+		if (node.count > 0) {
+			for (uint32_t i = node.right_or_first; i < node.right_or_first + node.count; i++) {
+				max_distance = f(bvh.primitive_indices[i], max_distance);
+			}
+			continue;
+		}
+
+		assert(stack_size + 2 <= std::size(stack));
+		stack[stack_size++] = node.right_or_first;
+		stack[stack_size++] = static_cast<uint32_t>(&node - bvh.nodes.data()) + 1;
+	}
+}
+
+// true if the cell in column x and row z of a heightfield has no triangles
+inline bool is_hole(const HeightfieldCollider &heightfield, const uint32_t x, const uint32_t z) {
+	return !heightfield.holes.empty() && heightfield.holes[z * (heightfield.columns - 1) + x];
+}
+
+// local space corners of one of the two triangles (half 0 or 1) of the cell in column x and row z of a heightfield.
+// both face up (+y) with counter clockwise corners
+inline void heightfield_triangle(
+	const HeightfieldCollider &heightfield, const uint32_t x, const uint32_t z, const uint32_t half,
+	Terathon::Vector3D &a, Terathon::Vector3D &b, Terathon::Vector3D &c
+) {
+	const auto sample = [&heightfield](const uint32_t column, const uint32_t row) {
+		return Terathon::Vector3D(
+			column * heightfield.cell_size, heightfield.heights[row * heightfield.columns + column], row * heightfield.cell_size
+		);
+	};
+	a = sample(x, z);
+	b = half == 0 ? sample(x, z + 1) : sample(x + 1, z + 1);
+	c = half == 0 ? sample(x + 1, z + 1) : sample(x + 1, z);
+}
+
+inline CookedTriangle cook_triangle(
+	const Terathon::Vector3D &a, const Terathon::Vector3D &b, const Terathon::Vector3D &c, const uint32_t triangle_index
+) {
+	CookedTriangle triangle;
+	triangle.a = Terathon::Point3D(a);
+	triangle.b = Terathon::Point3D(b);
+	triangle.c = Terathon::Point3D(c);
+	triangle.e_ab = Terathon::Wedge(triangle.a, triangle.b);
+	triangle.e_bc = Terathon::Wedge(triangle.b, triangle.c);
+	triangle.e_ca = Terathon::Wedge(triangle.c, triangle.a);
+	triangle.triangle_index = triangle_index;
+	return triangle;
+}
+
+} // tics
@@ -42,7 +42,10 @@ static Terathon::Vector3D get_velocity(tics::RigidBody *rb, const Terathon::Vect
 }
 
 void ImpulseSolver::solve(const std::vector<Collision>& collisions, float delta) {
-	for (auto collision : collisions) {
+	m_impulses.assign(collisions.size(), Terathon::Vector3D(0,0,0));
+
+	for (size_t collision_index = 0; collision_index < collisions.size(); collision_index++) {
+		const auto &collision = collisions[collision_index];
 		auto sp_a = collision.a.lock();
 		auto sp_b = collision.b.lock();
 		if (!sp_a || !sp_b) { continue; }
@@ -112,12 +115,24 @@ void ImpulseSolver::solve(const std::vector<Collision>& collisions, float delta)
 
 		// add impulse-based friction
 		const auto dynamic_friction_coefficient = 0.07;
-		const auto collision_tangent = Terathon::Normalize( v_r - (Terathon::Dot(v_r, n) * n) );
+		const auto tangential_velocity = v_r - (Terathon::Dot(v_r, n) * n);
+		const auto tangential_speed = Terathon::Magnitude(tangential_velocity);
+		// without tangential motion (e.g. a body falling straight onto the ground) there is no friction direction
+		const auto collision_tangent = tangential_speed > 1e-6f
+			? tangential_velocity / tangential_speed
+			: Terathon::Vector3D(0,0,0);
 		const auto friction_impulse = (
 			(impulse_magnitude * dynamic_friction_coefficient) * collision_tangent
 		);
 
-		const auto impulse = (impulse_magnitude * n) - friction_impulse;
+		// every contact of a pair stops the whole approach, the contacts of a compound share it
+		const auto impulse = ((impulse_magnitude * n) - friction_impulse) / static_cast<float>(collision.contact_count);
+		m_impulses[collision_index] = impulse;
+
+		// the angular impulses of the contacts of a compound add up, a single contact replaces the one of other pairs
+		const auto apply_angular_impulse = [&collision](RigidBody &rigid_body, const Terathon::Quaternion &rotation) {
+			rigid_body.an_imp_div_sq_dst = collision.contact_count > 1 ? rotation * rigid_body.an_imp_div_sq_dst : rotation;
+		};
 
 		// apply impulses only to rigid bodies
 		if (rb_a) {
@@ -127,7 +142,7 @@ void ImpulseSolver::solve(const std::vector<Collision>& collisions, float delta)
 			if (angular_impulse != Terathon::Vector3D(0,0,0)) {
 				auto str = Terathon::Magnitude(angular_impulse) * 0.1f / r_a_dist_squared;
 				const auto axis = Terathon::Normalize(angular_impulse);
-				rb_a->an_imp_div_sq_dst = Terathon::Quaternion::MakeRotation(str, !axis);
+				apply_angular_impulse(*rb_a, Terathon::Quaternion::MakeRotation(str, !axis));
 			}
 		}
 		if (rb_b) {
@@ -137,7 +152,7 @@ void ImpulseSolver::solve(const std::vector<Collision>& collisions, float delta)
 			if (angular_impulse != Terathon::Vector3D(0,0,0)) {
 				auto str = Terathon::Magnitude(angular_impulse) * 0.1f / r_b_dist_squared;
 				const auto axis = Terathon::Normalize(angular_impulse);
-				rb_b->an_imp_div_sq_dst = Terathon::Quaternion::MakeRotation(str, !axis);
+				apply_angular_impulse(*rb_b, Terathon::Quaternion::MakeRotation(str, !axis));
 			}
 		}
 	}
@@ -38,8 +38,9 @@ void NonIntersectionConstraintSolver::solve(const std::vector<Collision>& collis
 		const auto depth_tolerance = 0.01f; // how much they are allowed to glitch into another
 
 		const float depth_with_tolerance = fmax(collision.points.depth - depth_tolerance, 0.0f);
-		// distance that the objects are moved away from each other
-		const auto correction = collision.points.normal * ( percent *  depth_with_tolerance);
+		// distance that the objects are moved away from each other. the contacts of a compound share it
+		const auto correction = collision.points.normal * ( percent *  depth_with_tolerance)
+			/ static_cast<float>(collision.contact_count);
 
 		switch (object_combination) {
 			case RigidBodyRigidBody: {
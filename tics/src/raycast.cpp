@@ -1,8 +1,12 @@
 #include "tics.h"
+#include "geometry.h"
 
 #include <iostream>
 #include <sstream>
 #include <cassert>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 #include <TSRigid3D.h>
 #include <TSVector4D.h>
@@ -19,37 +23,19 @@ static std::string vec_to_str(Terathon::Vector3D v) {
 }
 
 bool tics::pga_raycast(const MeshCollider &mesh_collider, const Terathon::Point3D p, const Terathon::Vector3D v) {
+	assert(mesh_collider.triangles.size() == mesh_collider.indices.size() / 3 && "mesh collider is not cooked");
+
 	// the line l can be calculated once and used for all triangles
-	const auto pre_l = Terathon::Wedge(p, p + v);
-
-	for (size_t triangle_index = 0; triangle_index < mesh_collider.indices.size() / 3; triangle_index++) {
-		// vertex positions of current triangle
-		auto a = Terathon::Point3D(mesh_collider.positions.at(mesh_collider.indices.at(triangle_index * 3 + 0)));
-		auto b = Terathon::Point3D(mesh_collider.positions.at(mesh_collider.indices.at(triangle_index * 3 + 1)));
-		auto c = Terathon::Point3D(mesh_collider.positions.at(mesh_collider.indices.at(triangle_index * 3 + 2)));
-		// precalculated edge
-		const auto e_bc = mesh_collider.edges.at(triangle_index);
-
-		auto l = pre_l;
-		// Translate the line by subtracting (l.v cross a) from its moment l.m
-		// NOTE: The PGA Illuminated book uses a cross l.v but that gives incorrect results
-		l.m -= Terathon::Wedge(l.v, a);
-
-		// Translate vertices so a is the origin
-		b -= a;
-		c -= a;
-		// a = Terathon::Point3D::zero;
-
-		// Lines representing the edges of the triangle
-		const auto e_ab = Terathon::Line3D(b, Terathon::Bivector3D::zero);
-		// const auto e_bc = Terathon::Wedge(b, c);
-		const auto e_ca = Terathon::Line3D(-c, Terathon::Bivector3D::zero);
+	const auto l = Terathon::Wedge(p, p + v);
 
+	for (const auto &triangle : mesh_collider.triangles) {
+		// Lines representing the edges of the triangle are precalculated (see cook_mesh_collider).
+		// They are not translated to a, so l doesn't have to be translated either
 		// If any of the Antiwedge products is negative, then the line does not intersect the triangle.
 		const auto any_negative = (
-			Terathon::Antiwedge(l, e_ab) < 0 ||
-			Terathon::Antiwedge(l, e_bc) < 0 ||
-			Terathon::Antiwedge(l, e_ca) < 0
+			Terathon::Antiwedge(l, triangle.e_ab) < 0 ||
+			Terathon::Antiwedge(l, triangle.e_bc) < 0 ||
+			Terathon::Antiwedge(l, triangle.e_ca) < 0
 		);
 		if (!any_negative) {
 			return true;
@@ -60,10 +46,15 @@ bool tics::pga_raycast(const MeshCollider &mesh_collider, const Terathon::Point3
 }
 
 bool tics::raycast(const MeshCollider &mesh_collider, const Terathon::Vector3D p, const Terathon::Vector3D v) {
-	for (size_t triangle_index = 0; triangle_index < mesh_collider.indices.size() / 3; triangle_index++) {
-		auto a = Terathon::Point3D(mesh_collider.positions.at(mesh_collider.indices.at(triangle_index * 3 + 0)));
-		auto b = Terathon::Point3D(mesh_collider.positions.at(mesh_collider.indices.at(triangle_index * 3 + 1)));
-		auto c = Terathon::Point3D(mesh_collider.positions.at(mesh_collider.indices.at(triangle_index * 3 + 2)));
+	// read the flat triangle records if the collider is cooked, otherwise go through the indices
+	const auto cooked = !mesh_collider.triangles.empty();
+	const auto &positions = mesh_collider.positions;
+	const auto &indices = mesh_collider.indices;
+
+	for (size_t triangle_index = 0; triangle_index < indices.size() / 3; triangle_index++) {
+		auto a = cooked ? mesh_collider.triangles[triangle_index].a : Terathon::Point3D(positions[indices[triangle_index * 3 + 0]]);
+		auto b = cooked ? mesh_collider.triangles[triangle_index].b : Terathon::Point3D(positions[indices[triangle_index * 3 + 1]]);
+		auto c = cooked ? mesh_collider.triangles[triangle_index].c : Terathon::Point3D(positions[indices[triangle_index * 3 + 2]]);
 
 		// Let l be a line containing the point p and running parallel to the unit vector v
 
@@ -129,3 +120,232 @@ bool tics::raycast(const MeshCollider &mesh_collider, const Terathon::Vector3D p
 
 	return false;
 }
+
+// scalar triple product test (see tics::raycast), extended to compute the position of the hit
+static bool intersect_triangle(
+	Terathon::Vector3D a, Terathon::Vector3D b, Terathon::Vector3D c,
+	const Terathon::Vector3D &p, const Terathon::Vector3D &v, const float max_distance,
+	tics::RaycastHit &hit
+) {
+	// Translate the vertices so that p coincides with the origin
+	a -= p;
+	b -= p;
+	c -= p;
+
+	const auto scalar_triple_product_ab = Terathon::Dot( Terathon::Cross(a, b), v );
+	const auto scalar_triple_product_bc = Terathon::Dot( Terathon::Cross(b, c), v );
+	const auto scalar_triple_product_ca = Terathon::Dot( Terathon::Cross(c, a), v );
+	if (scalar_triple_product_ab > 0 || scalar_triple_product_bc > 0 || scalar_triple_product_ca > 0) {
+		return false;
+	}
+
+	// the sum is the dot product of the (unnormalized) triangle normal and v. it is 0 if v is parallel to the triangle
+	const auto sum = scalar_triple_product_ab + scalar_triple_product_bc + scalar_triple_product_ca;
+	if (sum == 0.0f) { return false; }
+
+	// each triple product is proportional to the area of the sub triangle opposite to a vertex
+	// -> they are the barycentric coordinates of the intersection point
+	const auto barycentric = Terathon::Vector3D(
+		scalar_triple_product_bc, scalar_triple_product_ca, scalar_triple_product_ab
+	) / sum;
+	const auto q = a * barycentric.x + b * barycentric.y + c * barycentric.z;
+	const auto distance = Terathon::Dot(q, v) / Terathon::Dot(v, v);
+
+	// the triple products test the whole line, we only want hits in front of the ray start
+	if (distance < 0.0f || distance >= max_distance) { return false; }
+
+	hit.distance = distance;
+	hit.barycentric = barycentric;
+	hit.normal = Terathon::Normalize( Terathon::Cross(b - a, c - a) );
+	hit.has_hit = true;
+	return true;
+}
+
+tics::RaycastHit tics::raycast_closest(
+	const MeshCollider &mesh_collider, const Terathon::Vector3D p, const Terathon::Vector3D v
+) {
+	auto hit = RaycastHit();
+	hit.distance = std::numeric_limits<float>::max();
+
+	const auto &positions = mesh_collider.positions;
+	const auto &indices = mesh_collider.indices;
+
+	const auto &nodes = mesh_collider.bvh.nodes;
+	if (nodes.empty()) {
+		// not cooked -> test all triangles
+		for (uint32_t triangle_index = 0; triangle_index < indices.size() / 3; triangle_index++) {
+			if (intersect_triangle(
+				positions[indices[triangle_index * 3 + 0]],
+				positions[indices[triangle_index * 3 + 1]],
+				positions[indices[triangle_index * 3 + 2]],
+				p, v, hit.distance, hit
+			)) {
+				hit.triangle_index = triangle_index;
+			}
+		}
+		if (!hit.has_hit) { hit.distance = 0.0f; }
+		return hit;
+	}
+
+	const auto inv_v = Terathon::Vector3D(1.0f / v.x, 1.0f / v.y, 1.0f / v.z);
+
+	// traverse the nodes front to back, so far away nodes can be skipped once we have a hit
+	struct StackEntry { uint32_t node_index; float distance; };
+	StackEntry stack [tics::bvh_max_depth + 1];
+	size_t stack_size = 0;
+	if (intersect_ray_aabb(nodes[0].bounds, p, inv_v, hit.distance) >= 0.0f) {
+		stack[stack_size++] = { 0, 0.0f };
+	}
+
+	while (stack_size > 0) {
+		const auto entry = stack[--stack_size];
+		// a closer hit was found after this node was pushed
+		if (entry.distance >= hit.distance) { continue; }
+
+		const auto &node = nodes[entry.node_index];
+		if (node.count > 0) {
+			for (uint32_t i = node.right_or_first; i < node.right_or_first + node.count; i++) {
+				const auto &triangle = mesh_collider.triangles[i];
+				if (intersect_triangle(triangle.a, triangle.b, triangle.c, p, v, hit.distance, hit)) {
+					hit.triangle_index = triangle.triangle_index;
+				}
+			}
+			continue;
+		}
+
+		auto near = StackEntry(entry.node_index + 1, 0.0f);
+		auto far = StackEntry(node.right_or_first, 0.0f);
+		near.distance = intersect_ray_aabb(nodes[near.node_index].bounds, p, inv_v, hit.distance);
+		far.distance = intersect_ray_aabb(nodes[far.node_index].bounds, p, inv_v, hit.distance);
+		if (far.distance >= 0.0f && near.distance >= 0.0f && far.distance < near.distance) {
+			std::swap(near, far);
+		}
+		// push the far child first, so the near child is processed first
+		assert(stack_size + 2 <= std::size(stack));
+		if (far.distance >= 0.0f) { stack[stack_size++] = far; }
+		if (near.distance >= 0.0f) { stack[stack_size++] = near; }
+	}
+
+	if (!hit.has_hit) { hit.distance = 0.0f; }
+	return hit;
+}
+
+tics::RaycastHit tics::raycast_closest(
+	const ScaledMeshCollider &scaled_mesh_collider, const Terathon::Vector3D p, const Terathon::Vector3D v
+) {
+	assert(scaled_mesh_collider.mesh);
+	const auto &s = scaled_mesh_collider.scale;
+	assert(s.x > 0.0f && s.y > 0.0f && s.z > 0.0f);
+
+	// cast the ray through the unscaled mesh. the scale is affine, so the hit distance and barycentric
+	// coordinates stay the same, only the normal has to be transformed (by the inverse transpose, 1 / scale)
+	const auto inv_s = Terathon::Vector3D(1.0f / s.x, 1.0f / s.y, 1.0f / s.z);
+	auto hit = raycast_closest(*scaled_mesh_collider.mesh, p * inv_s, v * inv_s);
+	if (hit.has_hit) { hit.normal = Terathon::Normalize(hit.normal * inv_s); }
+	return hit;
+}
+
+tics::RaycastHit tics::raycast_closest(
+	const CompoundCollider &compound_collider, const Terathon::Vector3D p, const Terathon::Vector3D v
+) {
+	auto closest = RaycastHit();
+	// f of for_each_primitive_on_ray: raycasts one child, returns the new max distance
+	const auto raycast_child = [&](const uint32_t child_index, const float max_distance) {
+		const auto &child = compound_collider.children[child_index];
+		if (!child.collider) { return max_distance; }
+		// boxes and spheres aren't hit, like box and sphere bodies in world raycasts: only triangles can be raycast
+		const auto type = child.collider->type;
+		if (type != MESH && type != TRIANGLE_MESH && type != SCALED_MESH && type != HEIGHTFIELD) { return max_distance; }
+
+		// the child transform is rigid, so the distance along the ray is the same in the space of the child
+		const auto inv_rotation = Terathon::Inverse(child.transform.get_rotation());
+		const auto child_p = Terathon::Transform(p - child.transform.get_position(), inv_rotation);
+		const auto child_v = Terathon::Transform(v, inv_rotation);
+		auto hit
+			= type == SCALED_MESH ? raycast_closest(static_cast<const ScaledMeshCollider &>(*child.collider), child_p, child_v)
+			: type == HEIGHTFIELD ? raycast_closest(static_cast<const HeightfieldCollider &>(*child.collider), child_p, child_v)
+			: raycast_closest(static_cast<const MeshCollider &>(*child.collider), child_p, child_v);
+		if (!hit.has_hit || hit.distance >= max_distance) { return max_distance; }
+		hit.normal = Terathon::Transform(hit.normal, child.transform.get_rotation());
+		closest = hit;
+		return hit.distance;
+	};
+
+	if (compound_collider.bvh.nodes.empty()) {
+		// not cooked -> test all children
+		auto max_distance = std::numeric_limits<float>::max();
+		for (uint32_t child_index = 0; child_index < compound_collider.children.size(); child_index++) {
+			max_distance = raycast_child(child_index, max_distance);
+		}
+		return closest;
+	}
+	for_each_primitive_on_ray(compound_collider.bvh, Ray { p, v }, raycast_child);
+	return closest;
+}
+
+tics::RaycastHit tics::raycast_closest(
+	const HeightfieldCollider &heightfield_collider, const Terathon::Vector3D p, const Terathon::Vector3D v
+) {
+	const auto &heightfield = heightfield_collider;
+	auto hit = RaycastHit();
+	if (heightfield.columns < 2 || heightfield.rows < 2) { return hit; }
+
+	// clip the ray to the bounds of the heightfield
+	const auto size_x = (heightfield.columns - 1) * heightfield.cell_size;
+	const auto size_z = (heightfield.rows - 1) * heightfield.cell_size;
+	const auto inv_v = Terathon::Vector3D(1.0f / v.x, 1.0f / v.y, 1.0f / v.z);
+	const auto bounds = AABB(
+		Terathon::Vector3D(0.0f, heightfield.min_height, 0.0f), Terathon::Vector3D(size_x, heightfield.max_height, size_z)
+	);
+	const auto t_enter = intersect_ray_aabb(bounds, p, inv_v, std::numeric_limits<float>::max());
+	if (t_enter < 0.0f) { return hit; }
+	// the exit is where the ray leaves the height range, the walk ends by itself where it leaves the grid
+	const auto t_exit_y = v.y == 0.0f ? std::numeric_limits<float>::max()
+		: std::max((heightfield.min_height - p.y) * inv_v.y, (heightfield.max_height - p.y) * inv_v.y);
+
+	// walk through the cells under the ray front to back (Amanatides and Woo), the first hit is the closest one
+	const auto start = p + v * t_enter;
+	const auto last_x = static_cast<int64_t>(heightfield.columns) - 2;
+	const auto last_z = static_cast<int64_t>(heightfield.rows) - 2;
+	auto x = std::clamp(static_cast<int64_t>(std::floor(start.x / heightfield.cell_size)), int64_t(0), last_x);
+	auto z = std::clamp(static_cast<int64_t>(std::floor(start.z / heightfield.cell_size)), int64_t(0), last_z);
+	const auto step_x = v.x >= 0.0f ? 1 : -1;
+	const auto step_z = v.z >= 0.0f ? 1 : -1;
+	const auto inf = std::numeric_limits<float>::infinity();
+	// distances along the ray to the next cell border in x and z, and between two borders
+	auto t_next_x = v.x == 0.0f ? inf : ((x + (step_x > 0 ? 1 : 0)) * heightfield.cell_size - p.x) * inv_v.x;
+	auto t_next_z = v.z == 0.0f ? inf : ((z + (step_z > 0 ? 1 : 0)) * heightfield.cell_size - p.z) * inv_v.z;
+	const auto t_delta_x = v.x == 0.0f ? inf : heightfield.cell_size * std::abs(inv_v.x);
+	const auto t_delta_z = v.z == 0.0f ? inf : heightfield.cell_size * std::abs(inv_v.z);
+
+	hit.distance = std::numeric_limits<float>::max();
+	auto t_cell = t_enter; // where the ray enters the current cell
+	while (x >= 0 && x <= last_x && z >= 0 && z <= last_z && t_cell <= t_exit_y) {
+		const auto cell_x = static_cast<uint32_t>(x);
+		const auto cell_z = static_cast<uint32_t>(z);
+		if (!is_hole(heightfield, cell_x, cell_z)) {
+			for (uint32_t half = 0; half < 2; half++) {
+				Terathon::Vector3D a, b, c;
+				heightfield_triangle(heightfield, cell_x, cell_z, half, a, b, c);
+				if (intersect_triangle(a, b, c, p, v, hit.distance, hit)) {
+					hit.triangle_index = 2 * (cell_z * (heightfield.columns - 1) + cell_x) + half;
+				}
+			}
+			if (hit.has_hit) { return hit; }
+		}
+
+		if (t_next_x < t_next_z) {
+			x += step_x;
+			t_cell = t_next_x;
+			t_next_x += t_delta_x;
+		}
+		else {
+			z += step_z;
+			t_cell = t_next_z;
+			t_next_z += t_delta_z;
+		}
+	}
+
+	hit.distance = 0.0f;
+	return hit;
+}
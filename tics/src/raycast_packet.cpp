@@ -0,0 +1,228 @@
+#include "tics.h"
+#include "geometry.h"
+#include "simd.h"
+
+#include <cassert>
+#include <limits>
+
+using tics::simd::FloatN;
+using tics::simd::Vector3N;
+
+size_t tics::ray_packet_width() {
+	return simd::width;
+}
+
+// one packet of rays in SoA layout. unused lanes of the last packet have max_distance 0 and never hit anything
+struct RayPacket {
+	Vector3N p;
+	Vector3N v;
+	Vector3N inv_v;
+	Vector3N moment; // p x v, the moment of the ray's line (for the Plücker formulation)
+	FloatN inv_v_dot_v;
+	FloatN max_distance; // shrinks to the distance of the closest hit
+
+	// lane data of the closest hits
+	float barycentric [3][tics::simd::width];
+	uint32_t triangle_index [tics::simd::width];
+};
+
+static RayPacket load_packet(const std::span<const tics::Ray> rays, const size_t first) {
+	float p [3][tics::simd::width];
+	float v [3][tics::simd::width];
+	float max_distance [tics::simd::width];
+	for (size_t lane = 0; lane < tics::simd::width; lane++) {
+		const auto valid = first + lane < rays.size();
+		const auto &ray = rays[valid ? first + lane : first];
+		p[0][lane] = ray.start.x; p[1][lane] = ray.start.y; p[2][lane] = ray.start.z;
+		v[0][lane] = ray.direction.x; v[1][lane] = ray.direction.y; v[2][lane] = ray.direction.z;
+		max_distance[lane] = valid ? ray.max_distance : 0.0f;
+	}
+
+	RayPacket packet;
+	const auto one = FloatN(1.0f);
+	packet.p = Vector3N(tics::simd::load(p[0]), tics::simd::load(p[1]), tics::simd::load(p[2]));
+	packet.v = Vector3N(tics::simd::load(v[0]), tics::simd::load(v[1]), tics::simd::load(v[2]));
+	packet.inv_v = Vector3N(one / packet.v.x, one / packet.v.y, one / packet.v.z);
+	packet.moment = tics::simd::cross(packet.p, packet.v);
+	packet.inv_v_dot_v = one / tics::simd::dot(packet.v, packet.v);
+	packet.max_distance = tics::simd::load(max_distance);
+	return packet;
+}
+
+// finishes the intersection of all lanes with the triangle abc, given the three signed values
+// (scalar triple products or antiwedge products) for the edges ab, bc and ca.
+// updates the lanes where this is the closest hit so far
+static void update_closest_hits(
+	RayPacket &packet, const uint32_t triangle_index,
+	const Vector3N &a, const Vector3N &b, const Vector3N &c,
+	const FloatN &side_ab, const FloatN &side_bc, const FloatN &side_ca
+) {
+	const auto zero = FloatN(0.0f);
+	// the line passes the triangle if no value is positive. the sum is 0 for lines parallel to the triangle
+	const auto sum = side_ab + side_bc + side_ca;
+	auto mask = (side_ab <= zero) & (side_bc <= zero) & (side_ca <= zero) & (sum < zero);
+	if (tics::simd::bits(mask) == 0) { return; }
+
+	// barycentric coordinates of the intersection, see intersect_triangle in raycast.cpp
+	const auto inv_sum = FloatN(1.0f) / sum;
+	const auto u = side_bc * inv_sum;
+	const auto v = side_ca * inv_sum;
+	const auto w = side_ab * inv_sum;
+	const auto q = a * u + b * v + c * w;
+	const auto distance = tics::simd::dot(q - packet.p, packet.v) * packet.inv_v_dot_v;
+
+	mask = mask & (zero <= distance) & (distance < packet.max_distance);
+	const auto lanes = tics::simd::bits(mask);
+	if (lanes == 0) { return; }
+
+	packet.max_distance = tics::simd::select(mask, distance, packet.max_distance);
+
+	float u_lanes [tics::simd::width], v_lanes [tics::simd::width], w_lanes [tics::simd::width];
+	tics::simd::store(u, u_lanes);
+	tics::simd::store(v, v_lanes);
+	tics::simd::store(w, w_lanes);
+	for (size_t lane = 0; lane < tics::simd::width; lane++) {
+		if (!(lanes & (1u << lane))) { continue; }
+		packet.barycentric[0][lane] = u_lanes[lane];
+		packet.barycentric[1][lane] = v_lanes[lane];
+		packet.barycentric[2][lane] = w_lanes[lane];
+		packet.triangle_index[lane] = triangle_index;
+	}
+}
+
+static void intersect_triangle_stp(
+	RayPacket &packet, const uint32_t triangle_index,
+	const Terathon::Vector3D &a, const Terathon::Vector3D &b, const Terathon::Vector3D &c
+) {
+	const auto a_n = Vector3N(a);
+	const auto b_n = Vector3N(b);
+	const auto c_n = Vector3N(c);
+
+	// Translate the vertices so that p coincides with the origin (different for every lane)
+	const auto a_p = a_n - packet.p;
+	const auto b_p = b_n - packet.p;
+	const auto c_p = c_n - packet.p;
+
+	// scalar triple products (a x b) dot v, (b x c) dot v, (c x a) dot v
+	update_closest_hits(
+		packet, triangle_index, a_n, b_n, c_n,
+		tics::simd::dot(tics::simd::cross(a_p, b_p), packet.v),
+		tics::simd::dot(tics::simd::cross(b_p, c_p), packet.v),
+		tics::simd::dot(tics::simd::cross(c_p, a_p), packet.v)
+	);
+}
+
+static void intersect_triangle_plucker(RayPacket &packet, const tics::CookedTriangle &triangle) {
+	// antiwedge product of the ray line and a precomputed edge line: l.v dot e.m + l.m dot e.v
+	// (equals the scalar triple product of the translated vertices). the edges are shared by all lanes
+	const auto side = [&packet](const Terathon::Line3D &e) {
+		const auto e_m = Vector3N(Terathon::Vector3D(e.m.x, e.m.y, e.m.z));
+		return tics::simd::dot(packet.v, e_m) + tics::simd::dot(packet.moment, Vector3N(e.v));
+	};
+
+	update_closest_hits(
+		packet, triangle.triangle_index, Vector3N(triangle.a), Vector3N(triangle.b), Vector3N(triangle.c),
+		side(triangle.e_ab), side(triangle.e_bc), side(triangle.e_ca)
+	);
+}
+
+// slab test for all lanes, returns the lanes that enter the box before their closest hit
+static uint32_t intersect_aabb(const RayPacket &packet, const tics::AABB &aabb) {
+	const auto t_0_x = (FloatN(aabb.min.x) - packet.p.x) * packet.inv_v.x;
+	const auto t_1_x = (FloatN(aabb.max.x) - packet.p.x) * packet.inv_v.x;
+	const auto t_0_y = (FloatN(aabb.min.y) - packet.p.y) * packet.inv_v.y;
+	const auto t_1_y = (FloatN(aabb.max.y) - packet.p.y) * packet.inv_v.y;
+	const auto t_0_z = (FloatN(aabb.min.z) - packet.p.z) * packet.inv_v.z;
+	const auto t_1_z = (FloatN(aabb.max.z) - packet.p.z) * packet.inv_v.z;
+
+	const auto t_enter = tics::simd::max(
+		tics::simd::max(tics::simd::min(t_0_x, t_1_x), tics::simd::min(t_0_y, t_1_y)),
+		tics::simd::max(tics::simd::min(t_0_z, t_1_z), FloatN(0.0f))
+	);
+	const auto t_exit = tics::simd::min(
+		tics::simd::min(tics::simd::max(t_0_x, t_1_x), tics::simd::max(t_0_y, t_1_y)),
+		tics::simd::min(tics::simd::max(t_0_z, t_1_z), packet.max_distance)
+	);
+	return tics::simd::bits(t_enter <= t_exit);
+}
+
+void tics::raycast_packet(
+	const MeshCollider &mesh_collider, const std::span<const Ray> rays, const std::span<RaycastHit> hits,
+	const RaycastFormulation formulation
+) {
+	assert(hits.size() >= rays.size());
+
+	const auto &positions = mesh_collider.positions;
+	const auto &indices = mesh_collider.indices;
+
+	const auto intersect_triangle = [formulation](RayPacket &packet, const CookedTriangle &triangle) {
+		if (formulation == PLUCKER) { intersect_triangle_plucker(packet, triangle); }
+		else { intersect_triangle_stp(packet, triangle.triangle_index, triangle.a, triangle.b, triangle.c); }
+	};
+
+	const auto &nodes = mesh_collider.bvh.nodes;
+
+	for (size_t first = 0; first < rays.size(); first += simd::width) {
+		auto packet = load_packet(rays, first);
+		for (auto &triangle_index : packet.triangle_index) {
+			triangle_index = std::numeric_limits<uint32_t>::max();
+		}
+
+		if (nodes.empty()) {
+			// not cooked -> test all triangles. the Plücker formulation needs the edge lines, so they are cooked on the fly
+			for (uint32_t triangle_index = 0; triangle_index < indices.size() / 3; triangle_index++) {
+				const auto &a = positions[indices[triangle_index * 3 + 0]];
+				const auto &b = positions[indices[triangle_index * 3 + 1]];
+				const auto &c = positions[indices[triangle_index * 3 + 2]];
+				if (formulation == PLUCKER) {
+					intersect_triangle_plucker(packet, cook_triangle(a, b, c, triangle_index));
+					continue;
+				}
+				intersect_triangle_stp(packet, triangle_index, a, b, c);
+			}
+		}
+		else {
+			// the packet visits a node if any of its rays hits the node
+			uint32_t stack [tics::bvh_max_depth + 1];
+			size_t stack_size = 0;
+			stack[stack_size++] = 0;
+			while (stack_size > 0) {
+				const auto node_index = stack[--stack_size];
+				const auto &node = nodes[node_index];
+				if (intersect_aabb(packet, node.bounds) == 0) { continue; }
+
+				if (node.count > 0) {
+					for (uint32_t i = node.right_or_first; i < node.right_or_first + node.count; i++) {
+						intersect_triangle(packet, mesh_collider.triangles[i]);
+					}
+					continue;
+				}
+
+				assert(stack_size + 2 <= std::size(stack));
+				stack[stack_size++] = node.right_or_first;
+				stack[stack_size++] = node_index + 1;
+			}
+		}
+
+		float distances [simd::width];
+		simd::store(packet.max_distance, distances);
+		for (size_t lane = 0; lane < simd::width && first + lane < rays.size(); lane++) {
+			auto &hit = hits[first + lane];
+			hit = RaycastHit();
+			if (packet.triangle_index[lane] == std::numeric_limits<uint32_t>::max()) { continue; }
+
+			const auto triangle_index = packet.triangle_index[lane];
+			const auto &a = positions[indices[triangle_index * 3 + 0]];
+			const auto &b = positions[indices[triangle_index * 3 + 1]];
+			const auto &c = positions[indices[triangle_index * 3 + 2]];
+
+			hit.distance = distances[lane];
+			hit.triangle_index = triangle_index;
+			hit.barycentric = Terathon::Vector3D(
+				packet.barycentric[0][lane], packet.barycentric[1][lane], packet.barycentric[2][lane]
+			);
+			hit.normal = Terathon::Normalize( Terathon::Cross(b - a, c - a) );
+			hit.has_hit = true;
+		}
+	}
+}
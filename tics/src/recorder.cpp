@@ -0,0 +1,249 @@
+#include "tics.h"
+#include "recorder.h"
+
+#include <algorithm>
+#include <cstring>
+
+using tics::Recorder;
+using tics::RecordedObject;
+using tics::World;
+
+// only the object types of tics can be recreated by a replay
+static bool recorded_object_type(const tics::ICollisionObject &object, uint32_t &type) {
+	if (dynamic_cast<const tics::RigidBody *>(&object)) { type = tics::RECORDED_RIGID_BODY; return true; }
+	if (dynamic_cast<const tics::StaticBody *>(&object)) { type = tics::RECORDED_STATIC_BODY; return true; }
+	if (dynamic_cast<const tics::CollisionArea *>(&object)) { type = tics::RECORDED_COLLISION_AREA; return true; }
+	return false;
+}
+
+Recorder::Recorder(const std::string &path) : m_file(path, std::ios::binary | std::ios::trunc) {
+	const auto header = RecordingHeader { recording_magic, recording_version, snapshot_flags() };
+	m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+bool Recorder::close() {
+	const auto was_open = is_open();
+	m_file.close();
+	return was_open && !m_file.fail();
+}
+
+void Recorder::write_event(const RecordedEventType type, const void *data, const size_t size) {
+	// after a failed write the file ends with a partial event, anything after it couldn't be read anyway
+	if (!m_file.good()) { return; }
+	const auto header = RecordedEventHeader { type, static_cast<uint32_t>(size) };
+	m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	m_file.write(reinterpret_cast<const char *>(data), size);
+}
+
+uint32_t Recorder::collider_id(const Collider &collider) {
+	const auto [it, is_new] = m_collider_ids.try_emplace(&collider, static_cast<uint32_t>(m_collider_ids.size() + 1));
+	if (is_new) { write_collider(collider, it->second); }
+	return it->second;
+}
+
+void Recorder::write_collider(const Collider &collider, const uint32_t id) {
+	std::vector<uint8_t> data;
+	const auto append = [&data](const void *p, const size_t size) {
+		data.insert(data.end(), static_cast<const uint8_t *>(p), static_cast<const uint8_t *>(p) + size);
+	};
+	const auto append_u32 = [&append](const uint32_t value) { append(&value, sizeof(value)); };
+	const auto append_vector = [&append](const Terathon::Vector3D &v) {
+		const float f [3] = { v.x, v.y, v.z };
+		append(f, sizeof(f));
+	};
+
+	append_u32(id);
+	append_u32(collider.type);
+	switch (collider.type) {
+		case SPHERE: {
+			const auto &sphere = static_cast<const SphereCollider &>(collider);
+			append_vector(sphere.center);
+			append(&sphere.radius, sizeof(float));
+			break;
+		}
+		case PLANE: {
+			const auto &plane = static_cast<const PlaneCollider &>(collider);
+			append_vector(plane.normal);
+			append(&plane.distance, sizeof(float));
+			break;
+		}
+		case BOX: {
+			append_vector(static_cast<const BoxCollider &>(collider).half_extents);
+			break;
+		}
+		case MESH:
+		case TRIANGLE_MESH: {
+			// only the source data, the replay cooks the collider again if it was cooked
+			const auto &mesh = static_cast<const MeshCollider &>(collider);
+			append_u32(mesh.bvh.nodes.empty() ? 0 : 1);
+			append_u32(static_cast<uint32_t>(mesh.positions.size()));
+			append_u32(static_cast<uint32_t>(mesh.indices.size()));
+			for (const auto &p : mesh.positions) { append_vector(p); }
+			append(mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+			break;
+		}
+		case SCALED_MESH: {
+			const auto &scaled_mesh = static_cast<const ScaledMeshCollider &>(collider);
+			append_u32(collider_id(*scaled_mesh.mesh));
+			append_vector(scaled_mesh.scale);
+			break;
+		}
+		case HEIGHTFIELD: {
+			// the replay computes the height range again
+			const auto &heightfield = static_cast<const HeightfieldCollider &>(collider);
+			append_u32(heightfield.columns);
+			append_u32(heightfield.rows);
+			append(&heightfield.cell_size, sizeof(float));
+			append(heightfield.heights.data(), heightfield.heights.size() * sizeof(float));
+			append_u32(static_cast<uint32_t>(heightfield.holes.size()));
+			for (const auto hole : heightfield.holes) { data.push_back(hole ? 1 : 0); }
+			break;
+		}
+		case COMPOUND: {
+			// the children are written before the compound, the replay builds the child BVH again if it was built
+			const auto &compound = static_cast<const CompoundCollider &>(collider);
+			append_u32(compound.bvh.nodes.empty() ? 0 : 1);
+			append_u32(static_cast<uint32_t>(compound.children.size()));
+			for (const auto &child : compound.children) {
+				append_u32(child.collider ? collider_id(*child.collider) : 0);
+				float transform [8];
+				store(transform, child.transform);
+				append(transform, sizeof(transform));
+			}
+			break;
+		}
+		case TRIANGLE: {
+			const auto &triangle = static_cast<const TriangleCollider &>(collider);
+			append_vector(triangle.a);
+			append_vector(triangle.b);
+			append_vector(triangle.c);
+			break;
+		}
+	}
+	write_event(EVENT_COLLIDER, data.data(), data.size());
+}
+
+RecordedObject Recorder::record_object(const ICollisionObject &object) {
+	auto recorded = RecordedObject {};
+	recorded.state = object_state(&object);
+	recorded_object_type(object, recorded.type);
+	recorded.collision_layer = object.collision_layer;
+	recorded.collision_mask = object.collision_mask;
+
+	if (const auto sp_collider = object.get_collider().lock()) {
+		recorded.collider_id = collider_id(*sp_collider);
+	}
+
+	if (const auto rigid_body = dynamic_cast<const RigidBody *>(&object)) {
+		recorded.mass = rigid_body->mass;
+		recorded.elasticity = rigid_body->elasticity;
+		recorded.gravity_scale = rigid_body->gravity_scale;
+		if (rigid_body->continuous_collision_detection) { recorded.flags |= RECORDED_CONTINUOUS_COLLISION_DETECTION; }
+	}
+	if (const auto static_body = dynamic_cast<const StaticBody *>(&object)) {
+		recorded.elasticity = static_body->elasticity;
+	}
+	if (const auto area = dynamic_cast<const CollisionArea *>(&object)) {
+		if (area->report_contact_data) { recorded.flags |= RECORDED_REPORT_CONTACT_DATA; }
+	}
+	return recorded;
+}
+
+void Recorder::add_object(const std::shared_ptr<ICollisionObject> &object) {
+	uint32_t type;
+	if (!recorded_object_type(*object, type)) { return; } // can't be replayed
+	const auto recorded = record_object(*object);
+	write_event(EVENT_ADD_OBJECT, recorded);
+	m_objects.push_back({ object, object->id, recorded });
+}
+
+void Recorder::remove_object(const ICollisionObject &object) {
+	const auto it = std::find_if(m_objects.begin(), m_objects.end(), [&object](const auto &tracked) {
+		return tracked.id == object.id;
+	});
+	if (it == m_objects.end()) { return; }
+	write_event(EVENT_REMOVE_OBJECT, it->id);
+	m_objects.erase(it);
+}
+
+void Recorder::add_solver(const ISolver &solver) {
+	uint32_t type;
+	if (dynamic_cast<const ImpulseSolver *>(&solver)) { type = RECORDED_IMPULSE_SOLVER; }
+	else if (dynamic_cast<const NonIntersectionConstraintSolver *>(&solver)) { type = RECORDED_NON_INTERSECTION_CONSTRAINT_SOLVER; }
+	else if (dynamic_cast<const CollisionAreaSolver *>(&solver)) { type = RECORDED_COLLISION_AREA_SOLVER; }
+	else { return; } // can't be replayed
+
+	const auto id = static_cast<uint32_t>(m_solver_ids.size() + 1);
+	m_solver_ids[&solver] = id;
+	const uint32_t data [2] = { id, type };
+	write_event(EVENT_ADD_SOLVER, data);
+}
+
+void Recorder::remove_solver(const ISolver &solver) {
+	const auto it = m_solver_ids.find(&solver);
+	if (it == m_solver_ids.end()) { return; }
+	write_event(EVENT_REMOVE_SOLVER, it->second);
+	m_solver_ids.erase(it);
+}
+
+void Recorder::set_gravity(const Terathon::Vector3D &gravity) {
+	const float data [3] = { gravity.x, gravity.y, gravity.z };
+	write_event(EVENT_SET_GRAVITY, data);
+}
+
+void Recorder::set_contact_events_enabled(const bool enabled) {
+	write_event(EVENT_SET_CONTACT_EVENTS_ENABLED, static_cast<uint32_t>(enabled));
+}
+
+void Recorder::begin_call(const RecordedEventType call, const float delta) {
+	for (auto it = m_objects.begin(); it != m_objects.end();) {
+		const auto sp_object = it->object.lock();
+		// destroyed without being removed from the world, the world skips it from now on
+		if (!sp_object) {
+			write_event(EVENT_REMOVE_OBJECT, it->id);
+			it = m_objects.erase(it);
+			continue;
+		}
+		const auto current = record_object(*sp_object);
+		if (std::memcmp(&current, &it->last, sizeof(RecordedObject)) != 0) {
+			write_event(EVENT_SET_OBJECT, current);
+			it->last = current;
+		}
+		it++;
+	}
+	write_event(call, delta);
+}
+
+void Recorder::end_call(const RecordedEventType call, const uint64_t state_hash) {
+	for (auto &tracked : m_objects) {
+		if (const auto sp_object = tracked.object.lock()) { tracked.last = record_object(*sp_object); }
+	}
+	if (call == EVENT_UPDATE) { write_event(EVENT_STATE_HASH, state_hash); }
+	m_file.flush();
+}
+
+bool World::start_recording(const std::string &path) {
+	auto recorder = std::make_shared<Recorder>(path);
+	if (!recorder->is_open()) { return false; }
+
+	// initial state
+	recorder->set_gravity(m_gravity);
+	recorder->set_contact_events_enabled(m_contact_events_enabled);
+	for (const auto &wp_solver : m_solvers) {
+		if (const auto sp_solver = wp_solver.lock()) { recorder->add_solver(*sp_solver); }
+	}
+	for (const auto &wp_object : m_objects) {
+		if (const auto sp_object = wp_object.lock()) { recorder->add_object(sp_object); }
+	}
+	if (!recorder->is_open()) { return false; }
+
+	m_recorder = recorder;
+	return true;
+}
+
+bool World::stop_recording() {
+	if (!m_recorder) { return true; }
+	const auto written = m_recorder->close();
+	m_recorder = nullptr;
+	return written;
+}
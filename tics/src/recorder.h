@@ -0,0 +1,123 @@
+#pragma once
+
+// recordings of world calls, written by World::start_recording and played back by tics::Replay.
+//
+// file layout: RecordingHeader, then events. every event is a RecordedEventHeader followed by `size` bytes.
+// the world is recorded with its initial state (objects, solvers, gravity) when the recording starts.
+// before every simulating call (update, collision_detection, collision_response) the objects are compared with
+// their state after the last call, so changes made by the game in between (impulses, teleports, property changes)
+// are recorded as SET_OBJECT events. colliders are written once, when the first object that uses them is recorded.
+// the mesh of a scaled mesh collider is written as a collider of its own before it, once for all its instances
+
+#include "tics.h"
+#include "snapshot.h"
+
+#include <fstream>
+#include <string>
+#include <unordered_map>
+
+namespace tics {
+
+const uint32_t recording_magic = 0x52434954; // "TICR"
+const uint32_t recording_version = 1;
+
+struct RecordingHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t flags; // SnapshotFlags
+};
+
+enum RecordedEventType : uint32_t {
+	EVENT_COLLIDER, // uint32 collider id, uint32 collider type, collider data (see Recorder::write_collider)
+	EVENT_ADD_OBJECT, // RecordedObject
+	EVENT_SET_OBJECT, // RecordedObject
+	EVENT_REMOVE_OBJECT, // uint32 object id
+	EVENT_ADD_SOLVER, // uint32 solver id, uint32 RecordedSolverType
+	EVENT_REMOVE_SOLVER, // uint32 solver id
+	EVENT_SET_GRAVITY, // float[3]
+	EVENT_SET_CONTACT_EVENTS_ENABLED, // uint32
+	EVENT_UPDATE, // float delta
+	EVENT_COLLISION_DETECTION, // float delta
+	EVENT_COLLISION_RESPONSE, // float delta. the collisions are the ones of the last collision detection
+	EVENT_STATE_HASH, // uint64 World::state_hash() after the last update
+};
+
+struct RecordedEventHeader {
+	uint32_t type;
+	uint32_t size;
+};
+
+enum RecordedObjectType : uint32_t {
+	RECORDED_STATIC_BODY,
+	RECORDED_RIGID_BODY,
+	RECORDED_COLLISION_AREA,
+};
+
+enum RecordedSolverType : uint32_t {
+	RECORDED_IMPULSE_SOLVER,
+	RECORDED_NON_INTERSECTION_CONSTRAINT_SOLVER,
+	RECORDED_COLLISION_AREA_SOLVER,
+};
+
+enum RecordedObjectFlags : uint32_t {
+	RECORDED_CONTINUOUS_COLLISION_DETECTION = 1,
+	RECORDED_REPORT_CONTACT_DATA = 2,
+};
+
+// everything about an object except its collider data
+struct RecordedObject {
+	ObjectState state;
+	uint32_t type; // RecordedObjectType
+	uint32_t collider_id; // 0 if it has none
+	uint32_t collision_layer;
+	uint32_t collision_mask;
+	uint32_t flags; // RecordedObjectFlags
+	float mass;
+	float elasticity;
+	float gravity_scale;
+};
+
+static_assert(std::is_trivially_copyable_v<RecordedObject>);
+
+class Recorder {
+public:
+	// the file is not open if it can't be written
+	Recorder(const std::string &path);
+	// false if the file couldn't be opened or a write failed since, the rest of the recording is dropped then
+	bool is_open() const { return m_file.is_open() && m_file.good(); }
+	// flushes and closes the file, returns false if anything couldn't be written
+	bool close();
+
+	void add_object(const std::shared_ptr<ICollisionObject> &object);
+	void remove_object(const ICollisionObject &object);
+	void add_solver(const ISolver &solver);
+	void remove_solver(const ISolver &solver);
+	void set_gravity(const Terathon::Vector3D &gravity);
+	void set_contact_events_enabled(const bool enabled);
+
+	// records everything that changed since the last call of end_call, then the call itself
+	void begin_call(const RecordedEventType call, const float delta);
+	// remembers the state of all objects after a call. the state hash is only written after updates
+	void end_call(const RecordedEventType call, const uint64_t state_hash);
+private:
+	struct TrackedObject {
+		std::weak_ptr<ICollisionObject> object;
+		uint32_t id;
+		RecordedObject last;
+	};
+
+	std::ofstream m_file;
+	std::vector<TrackedObject> m_objects = {};
+	std::unordered_map<const Collider *, uint32_t> m_collider_ids = {};
+	std::unordered_map<const ISolver *, uint32_t> m_solver_ids = {};
+
+	RecordedObject record_object(const ICollisionObject &object);
+	// id of a collider, the collider is written when it is seen for the first time
+	uint32_t collider_id(const Collider &collider);
+	void write_collider(const Collider &collider, const uint32_t id);
+	void write_event(const RecordedEventType type, const void *data, const size_t size);
+	template <typename T>
+	void write_event(const RecordedEventType type, const T &data) { write_event(type, &data, sizeof(T)); }
+};
+
+} // tics
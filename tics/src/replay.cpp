@@ -0,0 +1,317 @@
+#include "tics.h"
+#include "recorder.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+using tics::Replay;
+using tics::ReplayStep;
+
+// reads plain old data from an event payload, fails instead of reading past its end
+class PayloadReader {
+public:
+	PayloadReader(const uint8_t *data, const size_t size) : m_data(data), m_size(size) {}
+
+	template <typename T>
+	bool read(T &value) {
+		if (m_offset + sizeof(T) > m_size) { return false; }
+		std::memcpy(&value, m_data + m_offset, sizeof(T));
+		m_offset += sizeof(T);
+		return true;
+	}
+	bool read_vector(Terathon::Vector3D &v) {
+		float f [3];
+		if (!read(f)) { return false; }
+		v = Terathon::Vector3D(f[0], f[1], f[2]);
+		return true;
+	}
+private:
+	const uint8_t *m_data;
+	size_t m_size;
+	size_t m_offset = 0;
+};
+
+// colliders are the colliders read so far, scaled meshes and compounds refer to their mesh or children by id
+static std::shared_ptr<tics::Collider> read_collider(
+	PayloadReader &reader, const std::unordered_map<uint32_t, std::shared_ptr<tics::Collider>> &colliders, uint32_t &id
+) {
+	uint32_t type;
+	if (!reader.read(id) || !reader.read(type)) { return nullptr; }
+	switch (type) {
+		case tics::SPHERE: {
+			auto sphere = std::make_shared<tics::SphereCollider>();
+			if (!reader.read_vector(sphere->center) || !reader.read(sphere->radius)) { return nullptr; }
+			return sphere;
+		}
+		case tics::PLANE: {
+			auto plane = std::make_shared<tics::PlaneCollider>();
+			if (!reader.read_vector(plane->normal) || !reader.read(plane->distance)) { return nullptr; }
+			return plane;
+		}
+		case tics::BOX: {
+			auto box = std::make_shared<tics::BoxCollider>();
+			if (!reader.read_vector(box->half_extents)) { return nullptr; }
+			return box;
+		}
+		case tics::MESH:
+		case tics::TRIANGLE_MESH: {
+			auto mesh = type == tics::MESH
+				? std::make_shared<tics::MeshCollider>()
+				: std::static_pointer_cast<tics::MeshCollider>(std::make_shared<tics::TriangleMeshCollider>());
+			uint32_t cooked, position_count, index_count;
+			if (!reader.read(cooked) || !reader.read(position_count) || !reader.read(index_count)) { return nullptr; }
+			mesh->positions.resize(position_count);
+			for (auto &p : mesh->positions) {
+				if (!reader.read_vector(p)) { return nullptr; }
+			}
+			mesh->indices.resize(index_count);
+			for (auto &i : mesh->indices) {
+				if (!reader.read(i)) { return nullptr; }
+			}
+			if (cooked) { tics::cook_mesh_collider(*mesh); }
+			return mesh;
+		}
+		case tics::SCALED_MESH: {
+			auto scaled_mesh = std::make_shared<tics::ScaledMeshCollider>();
+			uint32_t mesh_id;
+			if (!reader.read(mesh_id) || !reader.read_vector(scaled_mesh->scale)) { return nullptr; }
+			const auto it = colliders.find(mesh_id);
+			if (it == colliders.end() || it->second->type != tics::MESH) { return nullptr; }
+			scaled_mesh->mesh = std::static_pointer_cast<const tics::MeshCollider>(it->second);
+			return scaled_mesh;
+		}
+		case tics::HEIGHTFIELD: {
+			auto heightfield = std::make_shared<tics::HeightfieldCollider>();
+			if (!reader.read(heightfield->columns) || !reader.read(heightfield->rows) || !reader.read(heightfield->cell_size)) {
+				return nullptr;
+			}
+			heightfield->heights.resize(size_t(heightfield->columns) * heightfield->rows);
+			for (auto &height : heightfield->heights) {
+				if (!reader.read(height)) { return nullptr; }
+			}
+			uint32_t hole_count;
+			if (!reader.read(hole_count)) { return nullptr; }
+			heightfield->holes.resize(hole_count);
+			for (size_t i = 0; i < hole_count; i++) {
+				uint8_t hole;
+				if (!reader.read(hole)) { return nullptr; }
+				heightfield->holes[i] = hole != 0;
+			}
+			tics::cook_heightfield_collider(*heightfield);
+			return heightfield;
+		}
+		case tics::TRIANGLE: {
+			auto triangle = std::make_shared<tics::TriangleCollider>();
+			if (!reader.read_vector(triangle->a) || !reader.read_vector(triangle->b) || !reader.read_vector(triangle->c)) {
+				return nullptr;
+			}
+			return triangle;
+		}
+		case tics::COMPOUND: {
+			auto compound = std::make_shared<tics::CompoundCollider>();
+			uint32_t cooked, child_count;
+			if (!reader.read(cooked) || !reader.read(child_count)) { return nullptr; }
+			compound->children.resize(child_count);
+			for (auto &child : compound->children) {
+				uint32_t child_id;
+				float transform [8];
+				if (!reader.read(child_id) || !reader.read(transform)) { return nullptr; }
+				if (child_id != 0) {
+					const auto it = colliders.find(child_id);
+					if (it == colliders.end()) { return nullptr; }
+					child.collider = it->second;
+				}
+				child.transform = tics::load_transform(transform);
+			}
+			if (cooked) { tics::cook_compound_collider(*compound); }
+			return compound;
+		}
+	}
+	return nullptr;
+}
+
+static void apply_properties(tics::ICollisionObject &object, const tics::RecordedObject &recorded) {
+	object.collision_layer = recorded.collision_layer;
+	object.collision_mask = recorded.collision_mask;
+	if (const auto rigid_body = dynamic_cast<tics::RigidBody *>(&object)) {
+		rigid_body->mass = recorded.mass;
+		rigid_body->elasticity = recorded.elasticity;
+		rigid_body->gravity_scale = recorded.gravity_scale;
+		rigid_body->continuous_collision_detection = recorded.flags & tics::RECORDED_CONTINUOUS_COLLISION_DETECTION;
+	}
+	if (const auto static_body = dynamic_cast<tics::StaticBody *>(&object)) {
+		static_body->elasticity = recorded.elasticity;
+	}
+	if (const auto area = dynamic_cast<tics::CollisionArea *>(&object)) {
+		area->report_contact_data = recorded.flags & tics::RECORDED_REPORT_CONTACT_DATA;
+	}
+	tics::apply_object_state(object, recorded.state);
+}
+
+bool Replay::open(const std::string &path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) { return false; }
+	m_data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+	auto header = RecordingHeader();
+	if (m_data.size() < sizeof(header)) { return false; }
+	std::memcpy(&header, m_data.data(), sizeof(header));
+	if (header.magic != recording_magic || header.version != recording_version || header.flags != snapshot_flags()) {
+		return false;
+	}
+	m_cursor = sizeof(header);
+
+	// the initial state, everything before the first update
+	auto step = ReplayStep();
+	while (m_cursor < m_data.size() && !next_is_update()) {
+		if (!play_event(step)) { return false; }
+	}
+	return true;
+}
+
+bool Replay::next_is_update() const {
+	auto header = RecordedEventHeader();
+	if (m_cursor + sizeof(header) > m_data.size()) { return false; }
+	std::memcpy(&header, m_data.data() + m_cursor, sizeof(header));
+	return header.type == EVENT_UPDATE;
+}
+
+bool Replay::step(ReplayStep &step) {
+	if (m_cursor >= m_data.size()) { return false; }
+	step = ReplayStep();
+	step.index = m_step_count++;
+	step.state_matches = true;
+
+	// the update, then everything up to the next update
+	do {
+		if (!play_event(step)) { return false; }
+	} while (m_cursor < m_data.size() && !next_is_update());
+	return true;
+}
+
+bool Replay::play_event(ReplayStep &step) {
+	auto header = RecordedEventHeader();
+	if (m_cursor + sizeof(header) > m_data.size()) { return false; }
+	std::memcpy(&header, m_data.data() + m_cursor, sizeof(header));
+	if (m_cursor + sizeof(header) + header.size > m_data.size()) { return false; }
+	auto reader = PayloadReader(m_data.data() + m_cursor + sizeof(header), header.size);
+	m_cursor += sizeof(header) + header.size;
+
+	using clock = std::chrono::high_resolution_clock;
+
+	switch (header.type) {
+		case EVENT_COLLIDER: {
+			uint32_t id;
+			auto collider = read_collider(reader, m_colliders, id);
+			if (!collider) { return false; }
+			m_colliders[id] = collider;
+			return true;
+		}
+		case EVENT_ADD_OBJECT: {
+			auto recorded = RecordedObject();
+			if (!reader.read(recorded)) { return false; }
+			auto object = std::shared_ptr<ICollisionObject>();
+			switch (recorded.type) {
+				case RECORDED_STATIC_BODY: object = std::make_shared<StaticBody>(); break;
+				case RECORDED_RIGID_BODY: object = std::make_shared<RigidBody>(); break;
+				case RECORDED_COLLISION_AREA: object = std::make_shared<CollisionArea>(); break;
+				default: return false;
+			}
+			auto transform = recorded.state.has_transform ? std::make_shared<Transform>() : nullptr;
+			object->set_transform(transform);
+			if (recorded.collider_id != 0) { object->set_collider(m_colliders[recorded.collider_id]); }
+			m_world.add_object(object);
+			// keep the recorded id, the state hashes include it
+			object->id = recorded.state.id;
+			apply_properties(*object, recorded);
+			m_objects[recorded.state.id] = { object, transform };
+			return true;
+		}
+		case EVENT_SET_OBJECT: {
+			auto recorded = RecordedObject();
+			if (!reader.read(recorded)) { return false; }
+			const auto it = m_objects.find(recorded.state.id);
+			if (it == m_objects.end()) { return false; }
+			if (recorded.collider_id != 0) { it->second.object->set_collider(m_colliders[recorded.collider_id]); }
+			apply_properties(*it->second.object, recorded);
+			return true;
+		}
+		case EVENT_REMOVE_OBJECT: {
+			uint32_t id;
+			if (!reader.read(id)) { return false; }
+			const auto it = m_objects.find(id);
+			if (it == m_objects.end()) { return false; }
+			m_world.remove_object(it->second.object);
+			m_objects.erase(it);
+			return true;
+		}
+		case EVENT_ADD_SOLVER: {
+			uint32_t data [2];
+			if (!reader.read(data)) { return false; }
+			auto solver = std::shared_ptr<ISolver>();
+			switch (data[1]) {
+				case RECORDED_IMPULSE_SOLVER: solver = std::make_shared<ImpulseSolver>(); break;
+				case RECORDED_NON_INTERSECTION_CONSTRAINT_SOLVER: solver = std::make_shared<NonIntersectionConstraintSolver>(); break;
+				case RECORDED_COLLISION_AREA_SOLVER: solver = std::make_shared<CollisionAreaSolver>(); break;
+				default: return false;
+			}
+			m_world.add_solver(solver);
+			m_solvers[data[0]] = solver;
+			return true;
+		}
+		case EVENT_REMOVE_SOLVER: {
+			uint32_t id;
+			if (!reader.read(id)) { return false; }
+			const auto it = m_solvers.find(id);
+			if (it == m_solvers.end()) { return false; }
+			m_world.remove_solver(it->second);
+			m_solvers.erase(it);
+			return true;
+		}
+		case EVENT_SET_GRAVITY: {
+			auto gravity = Terathon::Vector3D();
+			if (!reader.read_vector(gravity)) { return false; }
+			m_world.set_gravity(gravity);
+			return true;
+		}
+		case EVENT_SET_CONTACT_EVENTS_ENABLED: {
+			uint32_t enabled;
+			if (!reader.read(enabled)) { return false; }
+			m_world.set_contact_events_enabled(enabled);
+			return true;
+		}
+		case EVENT_UPDATE: {
+			float delta;
+			if (!reader.read(delta)) { return false; }
+			const auto start = clock::now();
+			m_world.update(delta);
+			step.update += clock::now() - start;
+			return true;
+		}
+		case EVENT_COLLISION_DETECTION: {
+			float delta;
+			if (!reader.read(delta)) { return false; }
+			const auto start = clock::now();
+			m_collisions = m_world.collision_detection(delta);
+			step.collision_detection += clock::now() - start;
+			step.collisions += m_collisions.size();
+			return true;
+		}
+		case EVENT_COLLISION_RESPONSE: {
+			float delta;
+			if (!reader.read(delta)) { return false; }
+			const auto start = clock::now();
+			m_world.collision_response(delta, m_collisions);
+			step.collision_response += clock::now() - start;
+			return true;
+		}
+		case EVENT_STATE_HASH: {
+			uint64_t hash;
+			if (!reader.read(hash)) { return false; }
+			step.state_matches = step.state_matches && hash == m_world.state_hash();
+			return true;
+		}
+	}
+	return false;
+}
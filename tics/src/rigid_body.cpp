@@ -14,8 +14,22 @@ std::weak_ptr<Collider> RigidBody::get_collider() const {
 
 void RigidBody::set_transform(const std::weak_ptr<Transform> transform) {
 	m_transform = transform;
+	m_transform_pointer = transform.lock().get();
+	if (const auto sp_transform = transform.lock()) {
+		previous_transform = *sp_transform;
+	}
 }
 
 std::weak_ptr<Transform> RigidBody::get_transform() const {
 	return m_transform;
 }
+
+Transform *RigidBody::peek_transform() const {
+	return m_transform.expired() ? nullptr : m_transform_pointer;
+}
+
+Transform RigidBody::get_interpolated_transform(const float alpha) const {
+	const auto sp_transform = m_transform.lock();
+	if (!sp_transform) { return previous_transform; }
+	return tics::interpolate(previous_transform, *sp_transform, alpha);
+}
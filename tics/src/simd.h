@@ -0,0 +1,114 @@
+#pragma once
+
+// minimal wide float type for processing several rays at once.
+// 8 lanes with AVX, 4 lanes with SSE, 1 lane otherwise. uses the Terathon platform detection (TSSimd.h)
+
+#include <TSMath.h>
+
+#include <cstdint>
+
+namespace tics::simd {
+
+#if defined(TERATHON_AVX)
+
+constexpr size_t width = 8;
+
+struct FloatN {
+	__m256 v;
+	FloatN() = default;
+	FloatN(const __m256 m) : v(m) {}
+	explicit FloatN(const float f) : v(_mm256_set1_ps(f)) {}
+};
+
+inline FloatN load(const float *p) { return _mm256_loadu_ps(p); }
+inline void store(const FloatN &a, float *p) { _mm256_storeu_ps(p, a.v); }
+inline FloatN operator+(const FloatN &a, const FloatN &b) { return _mm256_add_ps(a.v, b.v); }
+inline FloatN operator-(const FloatN &a, const FloatN &b) { return _mm256_sub_ps(a.v, b.v); }
+inline FloatN operator*(const FloatN &a, const FloatN &b) { return _mm256_mul_ps(a.v, b.v); }
+inline FloatN operator/(const FloatN &a, const FloatN &b) { return _mm256_div_ps(a.v, b.v); }
+inline FloatN min(const FloatN &a, const FloatN &b) { return _mm256_min_ps(a.v, b.v); }
+inline FloatN max(const FloatN &a, const FloatN &b) { return _mm256_max_ps(a.v, b.v); }
+// comparisons return lane masks (all bits set for true lanes)
+inline FloatN operator<(const FloatN &a, const FloatN &b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+inline FloatN operator<=(const FloatN &a, const FloatN &b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ); }
+inline FloatN operator&(const FloatN &a, const FloatN &b) { return _mm256_and_ps(a.v, b.v); }
+// a where the mask is set, b otherwise
+inline FloatN select(const FloatN &mask, const FloatN &a, const FloatN &b) { return _mm256_blendv_ps(b.v, a.v, mask.v); }
+// one bit per lane
+inline uint32_t bits(const FloatN &mask) { return static_cast<uint32_t>(_mm256_movemask_ps(mask.v)); }
+
+#elif defined(TERATHON_SSE)
+
+constexpr size_t width = 4;
+
+struct FloatN {
+	__m128 v;
+	FloatN() = default;
+	FloatN(const __m128 m) : v(m) {}
+	explicit FloatN(const float f) : v(_mm_set1_ps(f)) {}
+};
+
+inline FloatN load(const float *p) { return _mm_loadu_ps(p); }
+inline void store(const FloatN &a, float *p) { _mm_storeu_ps(p, a.v); }
+inline FloatN operator+(const FloatN &a, const FloatN &b) { return _mm_add_ps(a.v, b.v); }
+inline FloatN operator-(const FloatN &a, const FloatN &b) { return _mm_sub_ps(a.v, b.v); }
+inline FloatN operator*(const FloatN &a, const FloatN &b) { return _mm_mul_ps(a.v, b.v); }
+inline FloatN operator/(const FloatN &a, const FloatN &b) { return _mm_div_ps(a.v, b.v); }
+inline FloatN min(const FloatN &a, const FloatN &b) { return _mm_min_ps(a.v, b.v); }
+inline FloatN max(const FloatN &a, const FloatN &b) { return _mm_max_ps(a.v, b.v); }
+// comparisons return lane masks (all bits set for true lanes)
+inline FloatN operator<(const FloatN &a, const FloatN &b) { return _mm_cmplt_ps(a.v, b.v); }
+inline FloatN operator<=(const FloatN &a, const FloatN &b) { return _mm_cmple_ps(a.v, b.v); }
+inline FloatN operator&(const FloatN &a, const FloatN &b) { return _mm_and_ps(a.v, b.v); }
+// a where the mask is set, b otherwise (SSE2 has no blend instruction)
+inline FloatN select(const FloatN &mask, const FloatN &a, const FloatN &b) {
+	return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v));
+}
+// one bit per lane
+inline uint32_t bits(const FloatN &mask) { return static_cast<uint32_t>(_mm_movemask_ps(mask.v)); }
+
+#else
+
+constexpr size_t width = 1;
+
+// scalar fallback, masks are stored as 0.0 / 1.0
+struct FloatN {
+	float v;
+	FloatN() = default;
+	explicit FloatN(const float f) : v(f) {}
+};
+
+inline FloatN load(const float *p) { return FloatN(*p); }
+inline void store(const FloatN &a, float *p) { *p = a.v; }
+inline FloatN operator+(const FloatN &a, const FloatN &b) { return FloatN(a.v + b.v); }
+inline FloatN operator-(const FloatN &a, const FloatN &b) { return FloatN(a.v - b.v); }
+inline FloatN operator*(const FloatN &a, const FloatN &b) { return FloatN(a.v * b.v); }
+inline FloatN operator/(const FloatN &a, const FloatN &b) { return FloatN(a.v / b.v); }
+inline FloatN min(const FloatN &a, const FloatN &b) { return FloatN(a.v < b.v ? a.v : b.v); }
+inline FloatN max(const FloatN &a, const FloatN &b) { return FloatN(a.v > b.v ? a.v : b.v); }
+inline FloatN operator<(const FloatN &a, const FloatN &b) { return FloatN(a.v < b.v ? 1.0f : 0.0f); }
+inline FloatN operator<=(const FloatN &a, const FloatN &b) { return FloatN(a.v <= b.v ? 1.0f : 0.0f); }
+inline FloatN operator&(const FloatN &a, const FloatN &b) { return FloatN(a.v * b.v); }
+inline FloatN select(const FloatN &mask, const FloatN &a, const FloatN &b) { return mask.v != 0.0f ? a : b; }
+inline uint32_t bits(const FloatN &mask) { return mask.v != 0.0f ? 1u : 0u; }
+
+#endif
+
+// three wide floats, one lane per ray
+struct Vector3N {
+	FloatN x, y, z;
+	Vector3N() = default;
+	Vector3N(const FloatN &x, const FloatN &y, const FloatN &z) : x(x), y(y), z(z) {}
+	// same vector in every lane
+	explicit Vector3N(const Terathon::Vector3D &v) : x(FloatN(v.x)), y(FloatN(v.y)), z(FloatN(v.z)) {}
+};
+
+inline Vector3N operator+(const Vector3N &a, const Vector3N &b) { return Vector3N(a.x + b.x, a.y + b.y, a.z + b.z); }
+inline Vector3N operator-(const Vector3N &a, const Vector3N &b) { return Vector3N(a.x - b.x, a.y - b.y, a.z - b.z); }
+inline Vector3N operator*(const Vector3N &a, const FloatN &s) { return Vector3N(a.x * s, a.y * s, a.z * s); }
+inline FloatN dot(const Vector3N &a, const Vector3N &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline Vector3N cross(const Vector3N &a, const Vector3N &b) {
+	return Vector3N(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+} // tics::simd
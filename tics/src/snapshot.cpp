@@ -0,0 +1,120 @@
+#include "tics.h"
+#include "snapshot.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+using tics::World;
+using tics::ObjectState;
+
+// layout of a snapshot buffer:
+// SnapshotHeader, ObjectState[object_count], ContactPairState[contact_pair_count]
+// everything is plain old data, so the whole buffer is written and read with a few memcpy
+
+static const uint32_t snapshot_magic = 0x53434954; // "TICS"
+static const uint32_t snapshot_version = 1;
+
+struct SnapshotHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t flags;
+	uint32_t object_count;
+	uint32_t contact_pair_count;
+};
+
+struct ContactPairState {
+	uint32_t id_a;
+	uint32_t id_b;
+};
+
+static_assert(std::is_trivially_copyable_v<SnapshotHeader>);
+static_assert(std::is_trivially_copyable_v<ContactPairState>);
+
+// the kind of the object of an entry, expired if the object is gone
+static tics::ObjectKind entry_kind(const std::weak_ptr<tics::ICollisionObject> &wp_object, const uint32_t kind) {
+	return wp_object.expired() ? tics::OBJECT_EXPIRED : static_cast<tics::ObjectKind>(kind);
+}
+
+void World::snapshot(std::vector<uint8_t> &buffer) const {
+	const auto header = SnapshotHeader {
+		snapshot_magic, snapshot_version, snapshot_flags(),
+		static_cast<uint32_t>(m_objects.size()), static_cast<uint32_t>(m_contact_pairs.size())
+	};
+	buffer.resize(
+		sizeof(SnapshotHeader) + header.object_count * sizeof(ObjectState)
+		+ header.contact_pair_count * sizeof(ContactPairState)
+	);
+	std::memcpy(buffer.data(), &header, sizeof(header));
+
+	// the entries know the kind of every object, the objects are neither locked nor cast
+	auto *objects = buffer.data() + sizeof(SnapshotHeader);
+	for (uint32_t i = 0; i < m_objects.size(); i++) {
+		const auto &entry = m_object_entries[i];
+		const auto kind = entry_kind(m_objects[i], entry.kind);
+		const auto state = object_state(kind == OBJECT_EXPIRED ? nullptr : entry.object, kind);
+		std::memcpy(objects + i * sizeof(ObjectState), &state, sizeof(state));
+	}
+
+	auto *contact_pairs = objects + header.object_count * sizeof(ObjectState);
+	for (uint32_t i = 0; i < m_contact_pairs.size(); i++) {
+		const auto state = ContactPairState { m_contact_pairs[i].id_a, m_contact_pairs[i].id_b };
+		std::memcpy(contact_pairs + i * sizeof(ContactPairState), &state, sizeof(state));
+	}
+}
+
+bool World::restore(const std::span<const uint8_t> buffer) {
+	if (buffer.size() < sizeof(SnapshotHeader)) { return false; }
+	auto header = SnapshotHeader();
+	std::memcpy(&header, buffer.data(), sizeof(header));
+	if (header.magic != snapshot_magic || header.version != snapshot_version) { return false; }
+	if (header.flags != snapshot_flags() || header.object_count != m_objects.size()) { return false; }
+	const auto size = sizeof(SnapshotHeader) + header.object_count * sizeof(ObjectState)
+		+ header.contact_pair_count * sizeof(ContactPairState);
+	if (buffer.size() != size) { return false; }
+
+	// the states are copied out of the buffer one by one, it doesn't have to be aligned
+	const auto *objects = buffer.data() + sizeof(SnapshotHeader);
+	const auto read_u32 = [objects](const uint32_t object_index, const size_t offset) {
+		uint32_t value;
+		std::memcpy(&value, objects + object_index * sizeof(ObjectState) + offset, sizeof(value));
+		return value;
+	};
+
+	// the objects have to be the same ones (and still alive), check before changing anything
+	for (uint32_t i = 0; i < m_objects.size(); i++) {
+		const auto kind = entry_kind(m_objects[i], m_object_entries[i].kind);
+		if (read_u32(i, offsetof(ObjectState, kind)) != kind) { return false; }
+		if (kind != OBJECT_EXPIRED && read_u32(i, offsetof(ObjectState, id)) != m_object_entries[i].id) { return false; }
+	}
+
+	for (uint32_t i = 0; i < m_objects.size(); i++) {
+		if (m_objects[i].expired()) { continue; }
+		auto state = ObjectState();
+		std::memcpy(&state, objects + i * sizeof(ObjectState), sizeof(state));
+		apply_object_state(*m_object_entries[i].object, state);
+	}
+
+	// the entries are sorted by id
+	const auto find_object = [this](const uint32_t id) -> const ICollisionObject * {
+		auto it = std::lower_bound(
+			m_object_entries.begin(), m_object_entries.end(), id,
+			[](const ObjectEntry &entry, const uint32_t id) { return entry.id < id; }
+		);
+		for (; it != m_object_entries.end() && it->id == id; it++) {
+			if (it->object && !m_objects[it - m_object_entries.begin()].expired()) { return it->object; }
+		}
+		return nullptr;
+	};
+	const auto *contact_pairs = objects + header.object_count * sizeof(ObjectState);
+	m_contact_pairs.resize(header.contact_pair_count);
+	for (uint32_t i = 0; i < header.contact_pair_count; i++) {
+		auto state = ContactPairState();
+		std::memcpy(&state, contact_pairs + i * sizeof(ContactPairState), sizeof(state));
+		m_contact_pairs[i] = ContactPair { state.id_a, state.id_b, find_object(state.id_a), find_object(state.id_b) };
+	}
+
+	m_broadphase_dirty = true;
+	return true;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+// flat state records of objects, shared by snapshots and recordings
+
+#include "tics.h"
+
+#include <type_traits>
+
+namespace tics {
+
+enum SnapshotFlags : uint32_t {
+	SNAPSHOT_GA = 1, // transforms are motors
+};
+
+inline uint32_t snapshot_flags() {
+	#ifdef TICS_GA
+		return SNAPSHOT_GA;
+	#else
+		return 0;
+	#endif
+}
+
+enum ObjectKind : uint32_t {
+	OBJECT_EXPIRED = 0, // the object was destroyed, but not removed from the world
+	OBJECT_OTHER,
+	OBJECT_RIGID_BODY,
+};
+
+struct ObjectState {
+	uint32_t id;
+	uint32_t kind;
+	uint32_t has_transform;
+	float transform [8]; // motor (GA) or position + rotation (LA)
+	// rigid bodies only
+	float velocity [3];
+	float angular_velocity [4];
+	float impulse [3];
+	float an_imp_div_sq_dst [4];
+	float motor_velocity [8];
+};
+
+static_assert(std::is_trivially_copyable_v<ObjectState>);
+
+inline void store(float *out, const Terathon::Vector3D &v) { out[0] = v.x; out[1] = v.y; out[2] = v.z; }
+inline void store(float *out, const Terathon::Quaternion &q) { out[0] = q.x; out[1] = q.y; out[2] = q.z; out[3] = q.w; }
+inline void store(float *out, const Terathon::Motor3D &m) { store(out, m.v); store(out + 4, m.m); }
+inline Terathon::Vector3D load_vector(const float *in) { return Terathon::Vector3D(in[0], in[1], in[2]); }
+inline Terathon::Quaternion load_quaternion(const float *in) { return Terathon::Quaternion(in[0], in[1], in[2], in[3]); }
+inline Terathon::Motor3D load_motor(const float *in) {
+	auto m = Terathon::Motor3D();
+	m.v = load_quaternion(in);
+	m.m = load_quaternion(in + 4);
+	return m;
+}
+// 8 floats: motor (GA) or position + rotation (LA)
+inline void store(float *out, const Transform &t) {
+	#ifdef TICS_GA
+		store(out, t.motor);
+	#else
+		store(out, t.position);
+		store(out + 3, t.rotation);
+		out[7] = 0.0f;
+	#endif
+}
+inline Transform load_transform(const float *in) {
+	auto t = Transform();
+	#ifdef TICS_GA
+		t.motor = load_motor(in);
+	#else
+		t.position = load_vector(in);
+		t.rotation = load_quaternion(in + 3);
+	#endif
+	return t;
+}
+
+inline ObjectKind object_kind(const ICollisionObject *object) {
+	if (!object) { return OBJECT_EXPIRED; }
+	return dynamic_cast<const RigidBody *>(object) ? OBJECT_RIGID_BODY : OBJECT_OTHER;
+}
+
+// state of an object of the given kind, object can be nullptr for expired objects. unused fields are 0
+inline ObjectState object_state(const ICollisionObject *object, const ObjectKind kind) {
+	auto state = ObjectState {};
+	state.kind = kind;
+	if (!object) { return state; }
+
+	state.id = object->id;
+	if (const auto transform = object->peek_transform()) {
+		state.has_transform = 1;
+		store(state.transform, *transform);
+	}
+	if (state.kind == OBJECT_RIGID_BODY) {
+		const auto &rigid_body = static_cast<const RigidBody &>(*object);
+		store(state.velocity, rigid_body.velocity);
+		store(state.angular_velocity, rigid_body.angular_velocity);
+		store(state.impulse, rigid_body.impulse);
+		store(state.an_imp_div_sq_dst, rigid_body.an_imp_div_sq_dst);
+		store(state.motor_velocity, rigid_body.motor_velocity);
+	}
+	return state;
+}
+
+inline ObjectState object_state(const ICollisionObject *object) {
+	return object_state(object, object_kind(object));
+}
+
+// writes the state back, the object has to be of the same kind
+inline void apply_object_state(ICollisionObject &object, const ObjectState &state) {
+	if (state.has_transform) {
+		if (const auto transform = object.peek_transform()) { *transform = load_transform(state.transform); }
+	}
+	if (state.kind == OBJECT_RIGID_BODY) {
+		auto &rigid_body = static_cast<RigidBody &>(object);
+		rigid_body.velocity = load_vector(state.velocity);
+		rigid_body.angular_velocity = load_quaternion(state.angular_velocity);
+		rigid_body.impulse = load_vector(state.impulse);
+		rigid_body.an_imp_div_sq_dst = load_quaternion(state.an_imp_div_sq_dst);
+		rigid_body.motor_velocity = load_motor(state.motor_velocity);
+	}
+}
+
+} // tics
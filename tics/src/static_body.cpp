@@ -14,8 +14,13 @@ std::weak_ptr<Collider> StaticBody::get_collider() const {
 
 void StaticBody::set_transform(const std::weak_ptr<Transform> transform) {
 	m_transform = transform;
+	m_transform_pointer = transform.lock().get();
 }
 
 std::weak_ptr<Transform> StaticBody::get_transform() const {
 	return m_transform;
 }
+
+Transform *StaticBody::peek_transform() const {
+	return m_transform.expired() ? nullptr : m_transform_pointer;
+}
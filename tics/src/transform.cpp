@@ -0,0 +1,105 @@
+#include "tics.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cassert>
+
+using tics::Transform;
+using tics::simd::FloatN;
+
+Transform tics::interpolate(const Transform &from, const Transform &to, const float alpha) {
+	auto result = Transform();
+	#ifdef TICS_GA
+		// m and -m are the same motor, blend towards the closer one
+		const auto sign = Terathon::Dot(from.motor.v, to.motor.v) < 0.0f ? -1.0f : 1.0f;
+		// normalized linear blend, used += because no + operator exists
+		result.motor = from.motor * (1.0f - alpha);
+		result.motor += to.motor * (alpha * sign);
+		result.motor.Unitize();
+	#else
+		const auto sign = Terathon::Dot(from.rotation, to.rotation) < 0.0f ? -1.0f : 1.0f;
+		result.position = from.position * (1.0f - alpha) + to.position * alpha;
+		result.rotation = from.rotation * (1.0f - alpha) + to.rotation * (alpha * sign);
+		result.rotation.Normalize();
+	#endif
+	return result;
+}
+
+// components of a transform in a fixed order, so SIMD lanes can be filled from any build
+static void transform_components(const Transform &transform, float *components) {
+	#ifdef TICS_GA
+		const auto &v = transform.motor.v;
+		const auto &m = transform.motor.m;
+		const float c [8] = { v.x, v.y, v.z, v.w, m.x, m.y, m.z, m.w };
+	#else
+		const auto &p = transform.position;
+		const auto &r = transform.rotation;
+		const float c [8] = { r.x, r.y, r.z, r.w, p.x, p.y, p.z, 0.0f };
+	#endif
+	for (size_t i = 0; i < 8; i++) { components[i] = c[i]; }
+}
+
+void tics::write_transform_matrices(const std::span<const Transform> transforms, const std::span<float> matrices) {
+	assert(matrices.size() >= transforms.size() * 16);
+	const auto width = tics::simd::width;
+
+	// transposed into one row per component and out of one row per matrix element, one column per lane
+	alignas(32) float in [8][width];
+	alignas(32) float out [16][width];
+
+	for (size_t first = 0; first < transforms.size(); first += width) {
+		const auto count = std::min(width, transforms.size() - first);
+		for (size_t lane = 0; lane < width; lane++) {
+			// unused lanes repeat the last transform
+			float components [8];
+			transform_components(transforms[first + std::min(lane, count - 1)], components);
+			for (size_t c = 0; c < 8; c++) { in[c][lane] = components[c]; }
+		}
+
+		const auto vx = tics::simd::load(in[0]), vy = tics::simd::load(in[1]);
+		const auto vz = tics::simd::load(in[2]), vw = tics::simd::load(in[3]);
+		const auto one = FloatN(1.0f), two = FloatN(2.0f);
+
+		// rotation, same as Terathon's Motor3D::GetTransformMatrix / Quaternion::GetRotationMatrix
+		const auto xx = vx * vx, yy = vy * vy, zz = vz * vz;
+		const auto xy = vx * vy, xz = vz * vx, yz = vy * vz;
+		const auto zw = vz * vw, yw = vy * vw, xw = vx * vw;
+		const FloatN r [3][3] = {
+			{ one - (yy + zz) * two, (xy - zw) * two, (xz + yw) * two },
+			{ (xy + zw) * two, one - (zz + xx) * two, (yz - xw) * two },
+			{ (xz - yw) * two, (yz + xw) * two, one - (xx + yy) * two },
+		};
+
+		// translation
+		FloatN t [3];
+		#ifdef TICS_GA
+			const auto mx = tics::simd::load(in[4]), my = tics::simd::load(in[5]);
+			const auto mz = tics::simd::load(in[6]), mw = tics::simd::load(in[7]);
+			t[0] = (vy * mz - vz * my + mx * vw - vx * mw) * two;
+			t[1] = (vz * mx - vx * mz + my * vw - vy * mw) * two;
+			t[2] = (vx * my - vy * mx + mz * vw - vz * mw) * two;
+		#else
+			t[0] = tics::simd::load(in[4]);
+			t[1] = tics::simd::load(in[5]);
+			t[2] = tics::simd::load(in[6]);
+		#endif
+
+		// column major: element (row, column) is at column * 4 + row
+		const auto zero = FloatN(0.0f);
+		for (size_t row = 0; row < 3; row++) {
+			for (size_t column = 0; column < 3; column++) {
+				tics::simd::store(r[row][column], out[column * 4 + row]);
+			}
+			tics::simd::store(t[row], out[12 + row]);
+		}
+		tics::simd::store(zero, out[3]);
+		tics::simd::store(zero, out[7]);
+		tics::simd::store(zero, out[11]);
+		tics::simd::store(one, out[15]);
+
+		for (size_t lane = 0; lane < count; lane++) {
+			auto *matrix = matrices.data() + (first + lane) * 16;
+			for (size_t e = 0; e < 16; e++) { matrix[e] = out[e][lane]; }
+		}
+	}
+}
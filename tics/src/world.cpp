@@ -1,27 +1,52 @@
 #include "tics.h"
+#include "geometry.h"
+#include "recorder.h"
+#include "snapshot.h"
 
 #include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <chrono>
+#include <cstring>
 
 using namespace std::chrono_literals;
 
 using tics::World;
 
 void World::add_object(const std::weak_ptr<tics::ICollisionObject> object) {
+	const auto sp_object = object.lock();
+	if (sp_object) {
+		sp_object->id = m_next_object_id++;
+		if (m_recorder) { m_recorder->add_object(sp_object); }
+	}
 	m_objects.emplace_back(object);
+	// an object that is already gone gets the next id, which keeps the entries sorted
+	m_object_entries.push_back({
+		sp_object.get(), sp_object ? sp_object->id : m_next_object_id, static_cast<uint32_t>(object_kind(sp_object.get()))
+	});
+	m_broadphase_dirty = true;
 }
 
 void World::remove_object(const std::weak_ptr<tics::ICollisionObject> object) {
 	auto is_equals = [object](std::weak_ptr<tics::ICollisionObject> obj) {
 		return !obj.expired() && !object.expired() && object.lock() == obj.lock();
 	};
-	// find the object, move it to the end of the list and erase it
-	m_objects.erase(std::remove_if(m_objects.begin(), m_objects.end(), is_equals), m_objects.end());
+	if (const auto sp_object = object.lock(); sp_object && m_recorder) { m_recorder->remove_object(*sp_object); }
+	// find the object and erase it and its entry, keeping the order of the others
+	size_t kept = 0;
+	for (size_t i = 0; i < m_objects.size(); i++) {
+		if (is_equals(m_objects[i])) { continue; }
+		m_objects[kept] = m_objects[i];
+		m_object_entries[kept] = m_object_entries[i];
+		kept++;
+	}
+	m_objects.resize(kept);
+	m_object_entries.resize(kept);
+	m_broadphase_dirty = true;
 }
 
 void World::add_solver(const std::weak_ptr<ISolver> solver) {
+	if (const auto sp_solver = solver.lock(); sp_solver && m_recorder) { m_recorder->add_solver(*sp_solver); }
 	m_solvers.emplace_back(solver);
 }
 
@@ -29,6 +54,7 @@ void World::remove_solver(const std::weak_ptr<ISolver> solver) {
 	auto is_equals = [solver](std::weak_ptr<tics::ISolver> s) {
 		return !s.expired() && !solver.expired() && solver.lock() == s.lock();
 	};
+	if (const auto sp_solver = solver.lock(); sp_solver && m_recorder) { m_recorder->remove_solver(*sp_solver); }
 	// find the solver, move it to the end of the list and erase it
 	m_solvers.erase(std::remove_if(m_solvers.begin(), m_solvers.end(), is_equals), m_solvers.end());
 }
@@ -133,7 +159,45 @@ static void apply_dynamics(tics::RigidBody &rigid_body, const float delta, const
 	rigid_body.an_imp_div_sq_dst = Terathon::Quaternion::identity;
 }
 
+void World::continuous_collision(RigidBody &rigid_body, const Transform &start, const float delta) {
+	const auto sp_transform = rigid_body.get_transform().lock();
+	const auto sp_collider = rigid_body.get_collider().lock();
+	if (!sp_transform || !sp_collider || sp_collider->type == PLANE) { return; }
+
+	// sweep from the start position to the end of the step. the rotation is already the one at the end of the step
+	auto motion = sp_transform->get_position() - start.get_position();
+	auto transform = tics::translated(*sp_transform, -motion);
+	auto remaining = 1.0f; // part of the step that is left
+
+	// a body is sub stepped at most this many times per step. it stays at its last contact if it needs more
+	const size_t max_sub_steps = 4;
+	for (size_t sub_step = 0; sub_step < max_sub_steps; sub_step++) {
+		const auto hit = sweep(*sp_collider, transform, motion, &rigid_body, true);
+		if (!hit.has_hit) {
+			transform = tics::translated(transform, motion);
+			break;
+		}
+		transform = tics::translated(transform, motion * hit.fraction);
+
+		// bounce off the static body like in the ImpulseSolver (without friction and rotation)
+		const auto sp_static_body = std::static_pointer_cast<StaticBody>(hit.object.lock());
+		const auto n_dot_v = Terathon::Dot(rigid_body.velocity, hit.normal);
+		if (n_dot_v < 0.0f) {
+			const auto cor = rigid_body.elasticity * sp_static_body->elasticity;
+			rigid_body.velocity -= (1.0f + cor) * n_dot_v * hit.normal;
+		}
+
+		// move the rest of the step with the new velocity
+		remaining *= 1.0f - hit.fraction;
+		motion = rigid_body.velocity * (delta * remaining);
+	}
+
+	*sp_transform = transform;
+}
+
 void World::update(const float delta) {
+	if (m_recorder) { m_recorder->begin_call(EVENT_UPDATE, delta); }
+
 	static std::vector<std::chrono::nanoseconds> dynamics_times;
 	static std::vector<std::chrono::nanoseconds> collision_detection_times;
 	static std::vector<std::chrono::nanoseconds> collision_response_times;
@@ -154,12 +218,27 @@ void World::update(const float delta) {
 		if (auto sp_object = wp_object.lock()) {
 			const auto rigid_body = dynamic_cast<RigidBody *>(sp_object.get());
 			if (!rigid_body) { continue; }
+			if (const auto sp_transform = rigid_body->get_transform().lock()) {
+				rigid_body->previous_transform = *sp_transform;
+			}
+			if (!rigid_body->continuous_collision_detection || rigid_body->get_transform().expired()) {
+				apply_dynamics(*rigid_body, delta, m_gravity);
+				continue;
+			}
+			const auto start = *rigid_body->get_transform().lock();
 			apply_dynamics(*rigid_body, delta, m_gravity);
+			// static bodies don't move during the dynamics, so the broadphase stays valid for them
+			continuous_collision(*rigid_body, start, delta);
 		}
 	}
 	const auto d_time = std::chrono::high_resolution_clock::now() - d_start;
 	dynamics_times.push_back(d_time);
 
+	// objects moved, scene queries need to refresh the broadphase
+	m_broadphase_dirty = true;
+
+	if (m_recorder) { m_recorder->end_call(EVENT_UPDATE, state_hash()); }
+
 	std::chrono::nanoseconds cd_total = 0ns;
 	for (const auto &t : collision_detection_times) { cd_total += t; }
 	std::chrono::nanoseconds cr_total = 0ns;
@@ -185,42 +264,93 @@ void World::update(const float delta) {
 
 std::vector<tics::Collision> World::collision_detection(const float delta) {
 	std::vector<Collision> collisions;
+	collision_detection(delta, collisions);
+	return collisions;
+}
 
-	for (auto wp_a : m_objects) {
-		for (auto wp_b : m_objects) {
-			auto sp_a = wp_a.lock();
-			auto sp_b = wp_b.lock();
-			if (!sp_a || !sp_b) { continue; }
-
-			// break if both pointers point to the same object -> we will only check unique pairs
-			if (sp_a == sp_b) { break; }
-
-			// don't test static against static
-			const auto sb_a = dynamic_cast<StaticBody *>(sp_a.get());
-			const auto sb_b = dynamic_cast<StaticBody *>(sp_b.get());
-			if (sb_a && sb_b) { continue; }
-
-			if (sp_a->get_collider().expired() || sp_b->get_collider().expired() ||
-				sp_a->get_transform().expired() || sp_b->get_transform().expired()
-			) {
-				continue;
+void World::collision_detection(const float delta, std::vector<Collision> &collisions) {
+	if (m_recorder) { m_recorder->begin_call(EVENT_COLLISION_DETECTION, delta); }
+	collisions.clear();
+
+	// objects have moved since the last step, the bounds have to be recomputed.
+	// between the sub-steps of World::step, only bodies moved, so refitting the tree is enough
+	if (m_refit_broadphase) { refit_broadphase(); }
+	else { update_broadphase(); }
+	find_broadphase_pairs(m_broadphase_pairs);
+
+	for (const auto &[index_a, index_b] : m_broadphase_pairs) {
+		auto sp_a = m_objects[index_a].lock();
+		auto sp_b = m_objects[index_b].lock();
+		if (!sp_a || !sp_b) { continue; }
+
+		const auto sp_collider_a = sp_a->get_collider().lock();
+		const auto sp_collider_b = sp_b->get_collider().lock();
+		const auto sp_transform_a = sp_a->get_transform().lock();
+		const auto sp_transform_b = sp_b->get_transform().lock();
+		if (!sp_collider_a || !sp_collider_b || !sp_transform_a || !sp_transform_b) { continue; }
+		const auto &collider_a = *sp_collider_a;
+		const auto &collider_b = *sp_collider_b;
+		const auto &transform_a = *sp_transform_a;
+		const auto &transform_b = *sp_transform_b;
+
+		// areas that don't need contact data only need to know if they overlap, which skips EPA
+		const auto area_a = dynamic_cast<CollisionArea *>(sp_a.get());
+		const auto area_b = dynamic_cast<CollisionArea *>(sp_b.get());
+		if ((area_a || area_b)
+			&& !(area_a && area_a->report_contact_data) && !(area_b && area_b->report_contact_data)
+		) {
+			if (overlap_test(collider_a, transform_a, collider_b, transform_b)) {
+				const auto zero = Terathon::Vector3D(0,0,0);
+				collisions.emplace_back(sp_a, sp_b, CollisionPoints(zero, zero, zero, 0.0f, true));
 			}
+			continue;
+		}
 
-			auto collision_points = collision_test(
-				*(sp_a->get_collider().lock()), *(sp_a->get_transform().lock()),
-				*(sp_b->get_collider().lock()), *(sp_b->get_transform().lock())
-			);
-
-			if (collision_points.has_collision) {
-				collisions.emplace_back(sp_a, sp_b, collision_points);
-			}
+		// compounds have a contact per touching child, other pairs at most one
+		m_pair_contacts.clear();
+		collision_contacts(collider_a, transform_a, collider_b, transform_b, m_pair_contacts);
+		for (const auto &collision_points : m_pair_contacts) {
+			collisions.emplace_back(sp_a, sp_b, collision_points, static_cast<uint32_t>(m_pair_contacts.size()));
 		}
 	}
 
-	return collisions;
+	if (m_recorder) { m_recorder->end_call(EVENT_COLLISION_DETECTION, 0); }
+}
+
+void World::step(const float delta) {
+	const auto &settings = m_sub_stepping;
+	auto sub_step_count = settings.max_sub_steps;
+	if (settings.time_budget.count() > 0.0f && m_sub_step_time.count() > 0.0f) {
+		const auto affordable = static_cast<uint32_t>(settings.time_budget / m_sub_step_time);
+		sub_step_count = std::clamp(affordable, settings.min_sub_steps, settings.max_sub_steps);
+	}
+	m_sub_step_count = sub_step_count;
+
+	const auto start = std::chrono::high_resolution_clock::now();
+	const auto sub_delta = delta / sub_step_count;
+	for (uint32_t i = 0; i < sub_step_count; i++) {
+		update(sub_delta);
+		// the first sub-step builds the broadphase, objects may have been added or changed since the last step
+		m_refit_broadphase = i > 0;
+		collision_detection(sub_delta, m_step_collisions);
+		m_refit_broadphase = false;
+		collision_response(sub_delta, m_step_collisions);
+	}
+	const std::chrono::duration<float> time = std::chrono::high_resolution_clock::now() - start;
+
+	// the moving average follows changes within a few steps, without reacting to every single slow step
+	const auto sub_step_time = time / static_cast<float>(sub_step_count);
+	m_sub_step_time = m_sub_step_time.count() == 0.0f ? sub_step_time : m_sub_step_time * 0.75f + sub_step_time * 0.25f;
+}
+
+void World::set_sub_stepping(const SubStepping &sub_stepping) {
+	assert(sub_stepping.min_sub_steps >= 1 && sub_stepping.min_sub_steps <= sub_stepping.max_sub_steps);
+	m_sub_stepping = sub_stepping;
 }
 
 void World::collision_response(const float delta, const std::vector<tics::Collision> &collisions) {
+	if (m_recorder) { m_recorder->begin_call(EVENT_COLLISION_RESPONSE, delta); }
+
 	for (const auto& collision : collisions) {
 		if (m_collision_event) { m_collision_event(collision); }
 	}
@@ -230,12 +360,126 @@ void World::collision_response(const float delta, const std::vector<tics::Collis
 			sp_solver->solve(collisions, delta);
 		}
 	}
+
+	if (m_contact_events_enabled) { update_contact_events(collisions); }
+
+	if (m_recorder) { m_recorder->end_call(EVENT_COLLISION_RESPONSE, 0); }
+}
+
+void World::update_contact_events(const std::vector<Collision> &collisions) {
+	auto &events = m_contact_events;
+	events.begin.clear();
+	events.persist.clear();
+	events.end.clear();
+
+	// the impulses of the first impulse solver, they are in the same order as the collisions
+	std::shared_ptr<ISolver> sp_impulse_solver;
+	auto impulses = std::span<const Terathon::Vector3D>();
+	for (const auto &wp_solver : m_solvers) {
+		sp_impulse_solver = wp_solver.lock();
+		if (const auto impulse_solver = dynamic_cast<ImpulseSolver *>(sp_impulse_solver.get())) {
+			impulses = impulse_solver->get_impulses();
+			break;
+		}
+	}
+	if (impulses.size() != collisions.size()) { impulses = {}; }
+
+	std::swap(m_previous_contact_pairs, m_contact_pairs);
+	m_contact_pairs.clear();
+	const auto &previous = m_previous_contact_pairs;
+
+	for (size_t i = 0; i < collisions.size(); i++) {
+		const auto &collision = collisions[i];
+		const auto sp_a = collision.a.lock();
+		const auto sp_b = collision.b.lock();
+		if (!sp_a || !sp_b) { continue; }
+
+		const auto pair = ContactPair { sp_a->id, sp_b->id, sp_a.get(), sp_b.get() };
+		m_contact_pairs.push_back(pair);
+		const auto event = ContactEvent {
+			pair.a, pair.b, collision.points, impulses.empty() ? Terathon::Vector3D(0,0,0) : impulses[i]
+		};
+		const auto was_touching = std::binary_search(previous.begin(), previous.end(), pair);
+		(was_touching ? events.persist : events.begin).push_back(event);
+	}
+	// the contacts of a compound are one pair
+	std::sort(m_contact_pairs.begin(), m_contact_pairs.end());
+	m_contact_pairs.erase(std::unique(m_contact_pairs.begin(), m_contact_pairs.end()), m_contact_pairs.end());
+
+	// linear merge of the sorted pairs of both steps
+	const auto zero = Terathon::Vector3D(0,0,0);
+	auto it_current = m_contact_pairs.begin();
+	for (const auto &pair : previous) {
+		while (it_current != m_contact_pairs.end() && *it_current < pair) { it_current++; }
+		if (it_current != m_contact_pairs.end() && *it_current == pair) { continue; }
+		events.end.push_back({ pair.a, pair.b, CollisionPoints(zero, zero, zero, 0.0f, false), zero });
+	}
 }
 
 void World::set_gravity(const Terathon::Vector3D gravity) {
+	if (m_recorder) { m_recorder->set_gravity(gravity); }
 	m_gravity = gravity;
 }
 
 void World::set_collision_event(const std::function<void(const Collision&)> collision_event) {
 	m_collision_event = collision_event;
 }
+
+void World::set_contact_events_enabled(const bool enabled) {
+	if (m_recorder) { m_recorder->set_contact_events_enabled(enabled); }
+	m_contact_events_enabled = enabled;
+	m_contact_events = {};
+	m_contact_pairs.clear();
+}
+
+const tics::ContactEvents &World::get_contact_events() const {
+	return m_contact_events;
+}
+
+// FNV-1a over the bytes of a value
+static void hash_u32(uint64_t &hash, const uint32_t value) {
+	for (size_t byte = 0; byte < 4; byte++) {
+		hash ^= (value >> (byte * 8)) & 0xff;
+		hash *= 0x100000001b3;
+	}
+}
+
+// over the bits of every float, so even differences in the last bit change the hash
+static void hash_floats(uint64_t &hash, const float *floats, const size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		uint32_t bits;
+		std::memcpy(&bits, &floats[i], sizeof(bits));
+		hash_u32(hash, bits);
+	}
+}
+
+uint64_t World::state_hash() const {
+	uint64_t hash = 0xcbf29ce484222325;
+	for (const auto &wp_object : m_objects) {
+		const auto sp_object = wp_object.lock();
+		if (!sp_object) { continue; }
+		hash_u32(hash, sp_object->id);
+
+		if (const auto sp_transform = sp_object->get_transform().lock()) {
+			#ifdef TICS_GA
+				const auto &m = sp_transform->motor;
+				const float transform [8] = { m.v.x, m.v.y, m.v.z, m.v.w, m.m.x, m.m.y, m.m.z, m.m.w };
+			#else
+				const auto &p = sp_transform->position;
+				const auto &r = sp_transform->rotation;
+				const float transform [7] = { p.x, p.y, p.z, r.x, r.y, r.z, r.w };
+			#endif
+			hash_floats(hash, transform, std::size(transform));
+		}
+
+		if (const auto rigid_body = dynamic_cast<const RigidBody *>(sp_object.get())) {
+			const auto &v = rigid_body->velocity;
+			const auto &w = rigid_body->angular_velocity;
+			const auto &i = rigid_body->impulse;
+			const auto &j = rigid_body->an_imp_div_sq_dst;
+			const float state [14] = { v.x, v.y, v.z, w.x, w.y, w.z, w.w, i.x, i.y, i.z, j.x, j.y, j.z, j.w };
+			hash_floats(hash, state, std::size(state));
+		}
+	}
+	return hash;
+}
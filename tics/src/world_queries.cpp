@@ -0,0 +1,323 @@
+#include "tics.h"
+#include "geometry.h"
+
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+using tics::World;
+using tics::AABB;
+using tics::BVH;
+using tics::Ray;
+using tics::WorldRaycastHit;
+using tics::ShapeCastHit;
+
+AABB tics::collider_bounds(const Collider &collider) {
+	switch (collider.type) {
+		case tics::SPHERE: {
+			const auto &sphere = static_cast<const tics::SphereCollider &>(collider);
+			const auto r = Terathon::Vector3D(sphere.radius, sphere.radius, sphere.radius);
+			return AABB(sphere.center - r, sphere.center + r);
+		}
+		case tics::MESH:
+		case tics::TRIANGLE_MESH: {
+			const auto &mesh = static_cast<const tics::MeshCollider &>(collider);
+			// the root of a cooked BVH already contains the bounds
+			if (!mesh.bvh.nodes.empty()) { return mesh.bvh.nodes.front().bounds; }
+			auto bounds = tics::empty_aabb();
+			for (const auto &p : mesh.positions) { tics::grow(bounds, p); }
+			return bounds;
+		}
+		case tics::BOX: {
+			const auto &box = static_cast<const tics::BoxCollider &>(collider);
+			return AABB(-box.half_extents, box.half_extents);
+		}
+		case tics::SCALED_MESH: {
+			// the scale is positive, so the scaled bounds of the mesh are the bounds of the scaled mesh
+			const auto &scaled_mesh = static_cast<const tics::ScaledMeshCollider &>(collider);
+			const auto bounds = collider_bounds(*scaled_mesh.mesh);
+			return AABB(bounds.min * scaled_mesh.scale, bounds.max * scaled_mesh.scale);
+		}
+		case tics::HEIGHTFIELD: {
+			const auto &heightfield = static_cast<const tics::HeightfieldCollider &>(collider);
+			if (heightfield.columns == 0 || heightfield.rows == 0) { return tics::empty_aabb(); }
+			return AABB(
+				Terathon::Vector3D(0.0f, heightfield.min_height, 0.0f),
+				Terathon::Vector3D(
+					(heightfield.columns - 1) * heightfield.cell_size,
+					heightfield.max_height,
+					(heightfield.rows - 1) * heightfield.cell_size
+				)
+			);
+		}
+		case tics::COMPOUND: {
+			const auto &compound = static_cast<const tics::CompoundCollider &>(collider);
+			if (!compound.bvh.nodes.empty()) { return compound.bvh.nodes.front().bounds; }
+			auto bounds = tics::empty_aabb();
+			for (const auto &child : compound.children) {
+				if (child.collider) { tics::grow(bounds, tics::transform_aabb(collider_bounds(*child.collider), child.transform)); }
+			}
+			return bounds;
+		}
+		case tics::TRIANGLE: {
+			const auto &triangle = static_cast<const tics::TriangleCollider &>(collider);
+			auto bounds = tics::empty_aabb();
+			tics::grow(bounds, triangle.a);
+			tics::grow(bounds, triangle.b);
+			tics::grow(bounds, triangle.c);
+			return bounds;
+		}
+		case tics::PLANE:
+		default: {
+			const auto inf = std::numeric_limits<float>::max() * 0.5f;
+			return AABB(Terathon::Vector3D(-inf, -inf, -inf), Terathon::Vector3D(inf, inf, inf));
+		}
+	}
+}
+
+void World::update_broadphase() {
+	auto &bounds = m_broadphase_bounds;
+	bounds.clear();
+	bounds.reserve(m_objects.size());
+	m_broadphase_objects.clear();
+	m_unbounded_objects.clear();
+
+	for (uint32_t i = 0; i < m_objects.size(); i++) {
+		const auto sp_object = m_objects[i].lock();
+		if (!sp_object) { continue; }
+		const auto sp_collider = sp_object->get_collider().lock();
+		const auto sp_transform = sp_object->get_transform().lock();
+		if (!sp_collider || !sp_transform) { continue; }
+
+		const auto local_bounds = collider_bounds(*sp_collider);
+		if (local_bounds.min.x > local_bounds.max.x) { continue; } // empty collider
+		if (sp_collider->type == PLANE) {
+			m_unbounded_objects.push_back(i);
+			continue;
+		}
+
+		bounds.push_back(tics::transform_aabb(local_bounds, *sp_transform));
+		m_broadphase_objects.push_back(i);
+	}
+
+	m_broadphase_bvh = tics::build_bvh(bounds);
+	m_broadphase_dirty = false;
+}
+
+void World::refit_broadphase() {
+	auto &bounds = m_broadphase_bounds;
+	for (uint32_t i = 0; i < m_broadphase_objects.size(); i++) {
+		const auto sp_object = m_objects[m_broadphase_objects[i]].lock();
+		const auto sp_collider = sp_object ? sp_object->get_collider().lock() : nullptr;
+		const auto sp_transform = sp_object ? sp_object->get_transform().lock() : nullptr;
+		if (!sp_collider || !sp_transform) {
+			update_broadphase();
+			return;
+		}
+		bounds[i] = tics::transform_aabb(collider_bounds(*sp_collider), *sp_transform);
+	}
+	tics::refit_bvh(m_broadphase_bvh, bounds);
+	m_broadphase_dirty = false;
+}
+
+static bool passes_filter(const tics::ICollisionObject &a, const tics::ICollisionObject &b) {
+	// static bodies never move, they can't start touching each other
+	if (dynamic_cast<const tics::StaticBody *>(&a) && dynamic_cast<const tics::StaticBody *>(&b)) { return false; }
+	return (a.collision_layer & b.collision_mask) && (b.collision_layer & a.collision_mask);
+}
+
+void World::find_broadphase_pairs(std::vector<std::pair<uint32_t, uint32_t>> &pairs) {
+	pairs.clear();
+	const auto add_pair = [&](const uint32_t i, const uint32_t j) {
+		const auto sp_i = m_objects[i].lock();
+		const auto sp_j = m_objects[j].lock();
+		if (!sp_i || !sp_j || !passes_filter(*sp_i, *sp_j)) { return; }
+		pairs.emplace_back(std::max(i, j), std::min(i, j));
+	};
+
+	for (uint32_t primitive = 0; primitive < m_broadphase_objects.size(); primitive++) {
+		const auto i = m_broadphase_objects[primitive];
+		for_each_primitive_in_aabb(m_broadphase_bvh, m_broadphase_bounds[primitive], [&](const uint32_t other) {
+			// every pair is found from both sides, keep one
+			if (m_broadphase_objects[other] < i) { add_pair(i, m_broadphase_objects[other]); }
+		});
+	}
+	// planes can touch everything
+	for (size_t u = 0; u < m_unbounded_objects.size(); u++) {
+		for (const auto i : m_broadphase_objects) { add_pair(m_unbounded_objects[u], i); }
+		for (size_t v = 0; v < u; v++) { add_pair(m_unbounded_objects[u], m_unbounded_objects[v]); }
+	}
+
+	// same order as testing all objects against all earlier objects
+	std::sort(pairs.begin(), pairs.end());
+}
+
+void World::raycast_object(const uint32_t object_index, const Ray &ray, WorldRaycastHit &hit) const {
+	const auto sp_object = m_objects[object_index].lock();
+	if (!sp_object) { return; }
+	const auto sp_collider = sp_object->get_collider().lock();
+	const auto sp_transform = sp_object->get_transform().lock();
+	if (!sp_collider || !sp_transform) { return; }
+
+	// only meshes and heightfields (also as children of compounds) can be raycast at the moment
+	const auto type = sp_collider->type;
+	if (type != MESH && type != TRIANGLE_MESH && type != SCALED_MESH && type != HEIGHTFIELD && type != COMPOUND) { return; }
+
+	// move the ray into the local space of the object
+	const auto inv_rotation = Terathon::Inverse(sp_transform->get_rotation());
+	const auto local_start = Terathon::Transform(ray.start - sp_transform->get_position(), inv_rotation);
+	const auto local_direction = Terathon::Transform(ray.direction, inv_rotation);
+
+	const auto local_hit
+		= type == SCALED_MESH ? raycast_closest(static_cast<const ScaledMeshCollider &>(*sp_collider), local_start, local_direction)
+		: type == HEIGHTFIELD ? raycast_closest(static_cast<const HeightfieldCollider &>(*sp_collider), local_start, local_direction)
+		: type == COMPOUND ? raycast_closest(static_cast<const CompoundCollider &>(*sp_collider), local_start, local_direction)
+		: raycast_closest(static_cast<const MeshCollider &>(*sp_collider), local_start, local_direction);
+	// the transform is rigid, so distances along the ray stay the same
+	if (!local_hit.has_hit || local_hit.distance >= ray.max_distance) { return; }
+	if (hit.has_hit && local_hit.distance >= hit.distance) { return; }
+
+	hit.object = sp_object;
+	hit.distance = local_hit.distance;
+	hit.position = ray.start + ray.direction * local_hit.distance;
+	hit.normal = Terathon::Transform(local_hit.normal, sp_transform->get_rotation());
+	hit.triangle_index = local_hit.triangle_index;
+	hit.barycentric = local_hit.barycentric;
+	hit.has_hit = true;
+}
+
+WorldRaycastHit World::raycast(const Ray &ray) {
+	if (m_broadphase_dirty) { update_broadphase(); }
+
+	auto hit = WorldRaycastHit();
+	for_each_primitive_on_ray(m_broadphase_bvh, ray, [&](const uint32_t primitive, const float max_distance) {
+		raycast_object(m_broadphase_objects[primitive], ray, hit);
+		return hit.has_hit ? hit.distance : max_distance;
+	});
+	return hit;
+}
+
+std::vector<WorldRaycastHit> World::raycast_all(const Ray &ray) {
+	if (m_broadphase_dirty) { update_broadphase(); }
+
+	std::vector<WorldRaycastHit> hits;
+	for_each_primitive_on_ray(m_broadphase_bvh, ray, [&](const uint32_t primitive, const float max_distance) {
+		auto hit = WorldRaycastHit();
+		raycast_object(m_broadphase_objects[primitive], ray, hit);
+		if (hit.has_hit) { hits.push_back(hit); }
+		return max_distance;
+	});
+
+	std::sort(hits.begin(), hits.end(), [](const auto &a, const auto &b) { return a.distance < b.distance; });
+	return hits;
+}
+
+void World::raycast_batch(const std::span<const Ray> rays, const std::span<WorldRaycastHit> hits) {
+	assert(hits.size() >= rays.size());
+	if (m_broadphase_dirty) { update_broadphase(); }
+
+	const auto raycast_range = [this, rays, hits](const size_t begin, const size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			auto &hit = hits[i];
+			hit = WorldRaycastHit();
+			for_each_primitive_on_ray(m_broadphase_bvh, rays[i], [&](const uint32_t primitive, const float max_distance) {
+				raycast_object(m_broadphase_objects[primitive], rays[i], hit);
+				return hit.has_hit ? hit.distance : max_distance;
+			});
+		}
+	};
+
+	// starting threads costs a few microseconds, only worth it for larger batches
+	const size_t min_rays_per_thread = 64;
+	const auto thread_count = std::min<size_t>(
+		std::max(1u, std::thread::hardware_concurrency()), rays.size() / min_rays_per_thread
+	);
+	if (thread_count <= 1) {
+		raycast_range(0, rays.size());
+		return;
+	}
+
+	// every thread gets a contiguous range of rays and writes only to its own hits
+	std::vector<std::thread> threads;
+	threads.reserve(thread_count - 1);
+	const auto rays_per_thread = (rays.size() + thread_count - 1) / thread_count;
+	for (size_t t = 1; t < thread_count; t++) {
+		const auto begin = std::min(rays.size(), t * rays_per_thread);
+		const auto end = std::min(rays.size(), begin + rays_per_thread);
+		threads.emplace_back(raycast_range, begin, end);
+	}
+	raycast_range(0, std::min(rays.size(), rays_per_thread)); // the calling thread takes the first range
+	for (auto &thread : threads) { thread.join(); }
+}
+
+ShapeCastHit World::shape_cast(
+	const Collider &collider, const Transform &transform, const Terathon::Vector3D &motion,
+	const ICollisionObject *ignore
+) {
+	return sweep(collider, transform, motion, ignore, false);
+}
+
+ShapeCastHit World::sweep(
+	const Collider &collider, const Transform &transform, const Terathon::Vector3D &motion,
+	const ICollisionObject *ignore, const bool static_only
+) {
+	assert(collider.type != PLANE);
+	if (m_broadphase_dirty) { update_broadphase(); }
+
+	// candidates are the objects that overlap the bounds of the whole sweep
+	const auto start_bounds = tics::transform_aabb(collider_bounds(collider), transform);
+	auto swept_bounds = start_bounds;
+	tics::grow(swept_bounds, AABB(start_bounds.min + motion, start_bounds.max + motion));
+
+	auto hit = ShapeCastHit();
+	for_each_primitive_in_aabb(m_broadphase_bvh, swept_bounds, [&](const uint32_t primitive) {
+		const auto sp_object = m_objects[m_broadphase_objects[primitive]].lock();
+		if (!sp_object || sp_object.get() == ignore) { return; }
+		if (static_only && !dynamic_cast<StaticBody *>(sp_object.get())) { return; }
+		const auto sp_collider = sp_object->get_collider().lock();
+		const auto sp_transform = sp_object->get_transform().lock();
+		if (!sp_collider || !sp_transform) { return; }
+		// planes are not in the BVH, they have no support function anyway
+
+		const auto toi = time_of_impact(collider, transform, motion, *sp_collider, *sp_transform);
+		if (!toi.has_hit || (hit.has_hit && toi.fraction >= hit.fraction)) { return; }
+		// for static_only sweeps, bodies that already touch are left to the discrete collision detection
+		if (static_only && toi.fraction == 0.0f) { return; }
+
+		hit.object = sp_object;
+		hit.position = toi.point;
+		hit.normal = toi.normal;
+		hit.fraction = toi.fraction;
+		hit.has_hit = true;
+	});
+	return hit;
+}
+
+size_t World::overlap(
+	const Collider &collider, const Transform &transform, const std::span<std::weak_ptr<ICollisionObject>> out,
+	const ICollisionObject *ignore
+) {
+	assert(collider.type != PLANE);
+	if (m_broadphase_dirty) { update_broadphase(); }
+
+	size_t count = 0;
+	const auto test_object = [&](const uint32_t object_index) {
+		const auto &wp_object = m_objects[object_index];
+		const auto sp_object = wp_object.lock();
+		if (!sp_object || sp_object.get() == ignore) { return; }
+		const auto sp_collider = sp_object->get_collider().lock();
+		const auto sp_transform = sp_object->get_transform().lock();
+		if (!sp_collider || !sp_transform) { return; }
+
+		if (!overlap_test(collider, transform, *sp_collider, *sp_transform)) { return; }
+		if (count < out.size()) { out[count] = wp_object; }
+		count++;
+	};
+
+	const auto bounds = tics::transform_aabb(collider_bounds(collider), transform);
+	for_each_primitive_in_aabb(m_broadphase_bvh, bounds, [&](const uint32_t primitive) {
+		test_object(m_broadphase_objects[primitive]);
+	});
+	for (const auto object_index : m_unbounded_objects) { test_object(object_index); }
+	return count;
+}
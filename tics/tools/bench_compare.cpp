@@ -0,0 +1,395 @@
+// Stores benchmark baselines and compares new benchmark runs against them.
+//
+// Input is the output of a headless benchmark run: one sample per line, "<scenario> <nanoseconds>".
+// Empty lines and lines starting with '#' are ignored. Example:
+//   21xIcosphereHighres20sGA 404380
+//   21xIcosphereHighres20sGA 418571
+//   RaycastHitGA 1237085
+//
+// Usage:
+//   tics_bench_compare record  <baseline.json> [samples.txt]
+//   tics_bench_compare compare <baseline.json> [samples.txt] [--alpha <p>] [--threshold <ratio>]
+//
+// "record" (re)writes the baseline of every scenario that appears in the input, other scenarios are kept.
+// it fails instead of overwriting a baseline file that it can't read.
+// "compare" exits with 1 if any scenario got significantly slower:
+// the Mann-Whitney U test says the new samples are larger (one-sided, p < alpha)
+// and the median got slower by more than the threshold (default 2%).
+// Timings of tens of microseconds are noisy, that's why we need both conditions.
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using Samples = std::vector<double>;
+using Scenarios = std::map<std::string, Samples>;
+
+static double median(Samples samples) {
+	if (samples.empty()) { return 0.0; }
+	std::sort(samples.begin(), samples.end());
+	const auto n = samples.size();
+	return n % 2 == 1 ? samples[n/2] : 0.5 * (samples[n/2 - 1] + samples[n/2]);
+}
+
+// median absolute deviation, scaled so it is comparable to a standard deviation of normal distributed samples
+static double mad(const Samples &samples) {
+	const auto m = median(samples);
+	Samples deviations;
+	for (const auto s : samples) { deviations.push_back(std::abs(s - m)); }
+	return 1.4826 * median(deviations);
+}
+
+// distribution free confidence interval of the median using the order statistics around it
+// (normal approximation of the binomial distribution, 95%)
+static std::pair<double, double> median_confidence_interval(Samples samples) {
+	if (samples.empty()) { return { 0.0, 0.0 }; }
+	std::sort(samples.begin(), samples.end());
+	const auto n = static_cast<double>(samples.size());
+	const auto half_width = 1.96 * std::sqrt(n) * 0.5;
+	const auto lo = static_cast<long>(std::floor(n * 0.5 - half_width));
+	const auto hi = static_cast<long>(std::ceil(n * 0.5 + half_width));
+	const auto last = static_cast<long>(samples.size()) - 1;
+	return { samples[std::clamp(lo, 0l, last)], samples[std::clamp(hi, 0l, last)] };
+}
+
+// one-sided Mann-Whitney U test, returns the p-value for "current is stochastically greater than baseline"
+// uses the normal approximation with tie correction, which is fine for the sample counts we record
+static double mann_whitney_p_greater(const Samples &baseline, const Samples &current) {
+	const auto n1 = static_cast<double>(baseline.size());
+	const auto n2 = static_cast<double>(current.size());
+	if (n1 == 0 || n2 == 0) { return 1.0; }
+
+	// rank all samples together, equal values get the average of their ranks
+	std::vector<std::pair<double, bool>> all; // value, is_current
+	for (const auto s : baseline) { all.emplace_back(s, false); }
+	for (const auto s : current) { all.emplace_back(s, true); }
+	std::sort(all.begin(), all.end());
+
+	double rank_sum_current = 0.0;
+	double tie_term = 0.0;
+	for (size_t i = 0; i < all.size();) {
+		size_t j = i;
+		while (j < all.size() && all[j].first == all[i].first) { j++; }
+		const auto tie_count = static_cast<double>(j - i);
+		const auto average_rank = 0.5 * static_cast<double>(i + 1 + j);
+		for (size_t k = i; k < j; k++) {
+			if (all[k].second) { rank_sum_current += average_rank; }
+		}
+		tie_term += tie_count * tie_count * tie_count - tie_count;
+		i = j;
+	}
+
+	const auto u = rank_sum_current - n2 * (n2 + 1.0) * 0.5;
+	const auto mean_u = n1 * n2 * 0.5;
+	const auto n = n1 + n2;
+	const auto variance_u = n1 * n2 / 12.0 * ((n + 1.0) - tie_term / (n * (n - 1.0)));
+	if (variance_u <= 0.0) { return 1.0; } // all values are equal
+
+	// continuity correction
+	const auto z = (u - mean_u - 0.5) / std::sqrt(variance_u);
+	return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+static bool read_samples(std::istream &input, Scenarios &scenarios) {
+	std::string line;
+	size_t line_number = 0;
+	while (std::getline(input, line)) {
+		line_number++;
+		if (line.empty() || line[0] == '#') { continue; }
+		std::istringstream line_stream(line);
+		std::string scenario;
+		double sample;
+		if (!(line_stream >> scenario >> sample)) {
+			std::cerr << "invalid sample in line " << line_number << ": " << line << "\n";
+			return false;
+		}
+		scenarios[scenario].push_back(sample);
+	}
+	return true;
+}
+
+// minimal reader for the baseline files we write ourselves:
+// { "version": 1, "scenarios": { "<name>": { "median": x, "mad": x, "samples": [ x, ... ] }, ... } }
+class BaselineReader {
+public:
+	BaselineReader(const std::string &text) : m_text(text) {}
+
+	bool read(Scenarios &scenarios) {
+		if (!expect('{')) { return false; }
+		while (true) {
+			std::string key;
+			if (!read_string(key) || !expect(':')) { return false; }
+			if (key == "scenarios") {
+				if (!read_scenarios(scenarios)) { return false; }
+			}
+			else if (!skip_value()) { return false; }
+			if (peek() == ',') { m_pos++; continue; }
+			// nothing may follow the object
+			return expect('}') && peek() == '\0';
+		}
+	}
+private:
+	const std::string &m_text;
+	size_t m_pos = 0;
+
+	char peek() {
+		while (m_pos < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_pos]))) { m_pos++; }
+		return m_pos < m_text.size() ? m_text[m_pos] : '\0';
+	}
+
+	bool expect(const char c) {
+		if (peek() != c) { return false; }
+		m_pos++;
+		return true;
+	}
+
+	// the escapes write_string writes, and the other simple ones of JSON
+	bool read_string(std::string &out) {
+		if (!expect('"')) { return false; }
+		out.clear();
+		while (m_pos < m_text.size()) {
+			const auto c = m_text[m_pos++];
+			if (c == '"') { return true; }
+			if (c != '\\') { out += c; continue; }
+			if (m_pos >= m_text.size()) { return false; }
+			switch (const auto escaped = m_text[m_pos++]) {
+				case '"': case '\\': case '/': out += escaped; break;
+				case 'b': out += '\b'; break;
+				case 'f': out += '\f'; break;
+				case 'n': out += '\n'; break;
+				case 'r': out += '\r'; break;
+				case 't': out += '\t'; break;
+				case 'u': {
+					// only single bytes, write_string doesn't escape anything else
+					if (m_pos + 4 > m_text.size()) { return false; }
+					const auto digits = m_text.substr(m_pos, 4);
+					char *end = nullptr;
+					const auto code = std::strtoul(digits.c_str(), &end, 16);
+					if (end != digits.c_str() + 4 || code > 0x7f) { return false; }
+					out += static_cast<char>(code);
+					m_pos += 4;
+					break;
+				}
+				default: return false;
+			}
+		}
+		return false;
+	}
+
+	bool read_number(double &out) {
+		peek();
+		const char *begin = m_text.c_str() + m_pos;
+		char *end = nullptr;
+		out = std::strtod(begin, &end);
+		if (end == begin) { return false; }
+		m_pos += end - begin;
+		return true;
+	}
+
+	bool skip_value() {
+		const auto c = peek();
+		if (c == '"') { std::string s; return read_string(s); }
+		if (c == '{' || c == '[') {
+			const auto close = c == '{' ? '}' : ']';
+			m_pos++;
+			if (peek() == close) { m_pos++; return true; }
+			while (true) {
+				if (c == '{') {
+					std::string key;
+					if (!read_string(key) || !expect(':')) { return false; }
+				}
+				if (!skip_value()) { return false; }
+				if (peek() == ',') { m_pos++; continue; }
+				return expect(close);
+			}
+		}
+		double number;
+		return read_number(number);
+	}
+
+	bool read_scenarios(Scenarios &scenarios) {
+		if (!expect('{')) { return false; }
+		if (peek() == '}') { m_pos++; return true; }
+		while (true) {
+			std::string name;
+			if (!read_string(name) || !expect(':') || !expect('{')) { return false; }
+			while (true) {
+				std::string key;
+				if (!read_string(key) || !expect(':')) { return false; }
+				if (key == "samples") {
+					if (!expect('[')) { return false; }
+					auto &samples = scenarios[name];
+					samples.clear();
+					if (peek() == ']') { m_pos++; }
+					else {
+						while (true) {
+							double sample;
+							if (!read_number(sample)) { return false; }
+							samples.push_back(sample);
+							if (peek() == ',') { m_pos++; continue; }
+							if (!expect(']')) { return false; }
+							break;
+						}
+					}
+				}
+				else if (!skip_value()) { return false; }
+				if (peek() == ',') { m_pos++; continue; }
+				if (!expect('}')) { return false; }
+				break;
+			}
+			if (peek() == ',') { m_pos++; continue; }
+			return expect('}');
+		}
+	}
+};
+
+// a missing file is an empty baseline (found is false), returns false if the file exists but can't be read
+static bool read_baseline(const std::string &path, Scenarios &scenarios, bool &found) {
+	found = std::filesystem::exists(path);
+	if (!found) { return true; }
+	std::ifstream file(path);
+	if (!file) { return false; }
+	std::stringstream buffer;
+	buffer << file.rdbuf();
+	const auto text = buffer.str();
+	return BaselineReader(text).read(scenarios);
+}
+
+// JSON string with quotes, backslashes and control characters escaped
+static void write_string(std::ostream &out, const std::string &s) {
+	out << '"';
+	for (const auto c : s) {
+		if (c == '"' || c == '\\') { out << '\\' << c; }
+		else if (static_cast<unsigned char>(c) < 0x20) {
+			out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+		}
+		else { out << c; }
+	}
+	out << '"';
+}
+
+static bool write_baseline(const std::string &path, const Scenarios &scenarios) {
+	std::ofstream file(path);
+	if (!file) { return false; }
+	file << std::setprecision(10);
+	file << "{\n\t\"version\": 1,\n\t\"scenarios\": {";
+	auto first = true;
+	for (const auto &[name, samples] : scenarios) {
+		file << (first ? "\n" : ",\n");
+		first = false;
+		file << "\t\t";
+		write_string(file, name);
+		file << ": {\n"
+			<< "\t\t\t\"median\": " << median(samples) << ",\n"
+			<< "\t\t\t\"mad\": " << mad(samples) << ",\n"
+			<< "\t\t\t\"samples\": [";
+		for (size_t i = 0; i < samples.size(); i++) {
+			file << (i == 0 ? " " : ", ") << samples[i];
+		}
+		file << " ]\n\t\t}";
+	}
+	file << "\n\t}\n}\n";
+	return static_cast<bool>(file);
+}
+
+static int print_usage() {
+	std::cerr
+		<< "usage: tics_bench_compare record  <baseline.json> [samples.txt]\n"
+		<< "       tics_bench_compare compare <baseline.json> [samples.txt] [--alpha <p>] [--threshold <ratio>]\n";
+	return 2;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc < 3) { return print_usage(); }
+	const std::string command = argv[1];
+	const std::string baseline_path = argv[2];
+
+	std::string samples_path;
+	auto alpha = 0.01;
+	auto threshold = 0.02;
+	for (int i = 3; i < argc; i++) {
+		const std::string arg = argv[i];
+		if (arg == "--alpha" && i + 1 < argc) { alpha = std::stod(argv[++i]); }
+		else if (arg == "--threshold" && i + 1 < argc) { threshold = std::stod(argv[++i]); }
+		else if (samples_path.empty()) { samples_path = arg; }
+		else { return print_usage(); }
+	}
+
+	Scenarios current;
+	if (samples_path.empty()) {
+		if (!read_samples(std::cin, current)) { return 2; }
+	}
+	else {
+		std::ifstream samples_file(samples_path);
+		if (!samples_file) {
+			std::cerr << "could not open " << samples_path << "\n";
+			return 2;
+		}
+		if (!read_samples(samples_file, current)) { return 2; }
+	}
+
+	Scenarios baseline;
+	auto has_baseline = false;
+	if (!read_baseline(baseline_path, baseline, has_baseline)) {
+		// record would overwrite it, better check what's wrong with it first
+		std::cerr << "could not read " << baseline_path << ", it is not a baseline written by this tool\n";
+		return 2;
+	}
+
+	if (command == "record") {
+		for (const auto &[name, samples] : current) { baseline[name] = samples; }
+		if (!write_baseline(baseline_path, baseline)) {
+			std::cerr << "could not write " << baseline_path << "\n";
+			return 2;
+		}
+		std::cout << "recorded " << current.size() << " scenario(s) to " << baseline_path << "\n";
+		return 0;
+	}
+	if (command != "compare") { return print_usage(); }
+
+	if (!has_baseline) {
+		std::cerr << baseline_path << " does not exist\n";
+		return 2;
+	}
+
+	auto regression = false;
+	std::cout << std::fixed << std::setprecision(0);
+	for (const auto &[name, samples] : current) {
+		if (!baseline.contains(name)) {
+			std::cout << name << ": no baseline\n";
+			continue;
+		}
+		const auto &base_samples = baseline[name];
+
+		const auto base_median = median(base_samples);
+		const auto curr_median = median(samples);
+		const auto [base_lo, base_hi] = median_confidence_interval(base_samples);
+		const auto [curr_lo, curr_hi] = median_confidence_interval(samples);
+		const auto change = base_median != 0.0 ? (curr_median - base_median) / base_median : 0.0;
+		const auto p = mann_whitney_p_greater(base_samples, samples);
+
+		const auto is_regression = p < alpha && change > threshold;
+		regression = regression || is_regression;
+
+		std::cout
+			<< name << ": "
+			<< base_median << "ns [" << base_lo << ", " << base_hi << "] (mad " << mad(base_samples) << ") -> "
+			<< curr_median << "ns [" << curr_lo << ", " << curr_hi << "] (mad " << mad(samples) << ") "
+			<< std::showpos << std::setprecision(1) << change * 100.0 << "%" << std::noshowpos
+			<< std::setprecision(4) << " p=" << p
+			<< std::setprecision(0)
+			<< (is_regression ? " REGRESSION" : "")
+			<< "\n";
+	}
+
+	return regression ? 1 : 0;
+}
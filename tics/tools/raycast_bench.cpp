@@ -0,0 +1,111 @@
+// Headless raycast benchmark: a fan of nearly parallel rays from one origin against a high resolution sphere.
+// Compares the single ray path with the packet path (both formulations), with and without BVH.
+// Prints one sample per line ("<scenario> <nanoseconds>"), ready for tics_bench_compare.
+//
+// Usage: tics_raycast_bench [iterations]
+
+#include <tics.h>
+
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// uv sphere with outward facing triangles
+static tics::MeshCollider create_sphere_collider(const float radius, const uint32_t segments, const uint32_t rings) {
+	tics::MeshCollider collider;
+	const auto pi = 3.14159265f;
+	for (uint32_t ring = 0; ring <= rings; ring++) {
+		const auto theta = pi * ring / rings;
+		for (uint32_t segment = 0; segment < segments; segment++) {
+			const auto phi = 2.0f * pi * segment / segments;
+			collider.positions.push_back(Terathon::Vector3D(
+				radius * std::sin(theta) * std::cos(phi), radius * std::cos(theta), radius * std::sin(theta) * std::sin(phi)
+			));
+		}
+	}
+	for (uint32_t ring = 0; ring < rings; ring++) {
+		for (uint32_t segment = 0; segment < segments; segment++) {
+			const auto a = ring * segments + segment;
+			const auto b = ring * segments + (segment + 1) % segments;
+			const auto c = (ring + 1) * segments + segment;
+			const auto d = (ring + 1) * segments + (segment + 1) % segments;
+			if (ring != 0) { collider.indices.insert(collider.indices.end(), { a, b, c }); }
+			if (ring != rings - 1) { collider.indices.insert(collider.indices.end(), { b, d, c }); }
+		}
+	}
+	return collider;
+}
+
+static void run_scenario(const std::string &name, const size_t iterations, const std::function<void()> &f) {
+	f(); // warm up
+	for (size_t i = 0; i < iterations; i++) {
+		const auto start = std::chrono::high_resolution_clock::now();
+		f();
+		const auto time = std::chrono::high_resolution_clock::now() - start;
+		std::cout << name << " " << std::chrono::duration_cast<std::chrono::nanoseconds>(time).count() << "\n";
+	}
+}
+
+int main(int argc, char *argv[]) {
+	const size_t iterations = argc > 1 ? std::stoul(argv[1]) : 20;
+
+	const auto linear_collider = create_sphere_collider(1.0f, 128, 64);
+	auto cooked_collider = linear_collider;
+	tics::cook_mesh_collider(cooked_collider);
+
+	// 16x16 fan of rays from one origin, looking at the sphere
+	const size_t fan_size = 16;
+	std::vector<tics::Ray> rays;
+	for (size_t y = 0; y < fan_size; y++) {
+		for (size_t x = 0; x < fan_size; x++) {
+			auto ray = tics::Ray();
+			ray.start = Terathon::Vector3D(0.0f, 0.0f, -5.0f);
+			ray.direction = Terathon::Normalize(Terathon::Vector3D(
+				(x / (fan_size - 1.0f) - 0.5f) * 0.5f, (y / (fan_size - 1.0f) - 0.5f) * 0.5f, 1.0f
+			));
+			rays.push_back(ray);
+		}
+	}
+	std::vector<tics::RaycastHit> hits(rays.size());
+
+	std::cout
+		<< "# " << linear_collider.indices.size() / 3 << " triangles, " << rays.size() << " rays, "
+		<< "packet width " << tics::ray_packet_width() << "\n";
+
+	// make sure all paths agree before measuring them
+	std::vector<tics::RaycastHit> packet_hits(rays.size());
+	size_t mismatches = 0;
+	for (const auto formulation : { tics::SCALAR_TRIPLE_PRODUCT, tics::PLUCKER }) {
+		tics::raycast_packet(cooked_collider, rays, packet_hits, formulation);
+		for (size_t i = 0; i < rays.size(); i++) {
+			const auto hit = tics::raycast_closest(linear_collider, rays[i].start, rays[i].direction);
+			if (hit.has_hit != packet_hits[i].has_hit || (hit.has_hit && hit.triangle_index != packet_hits[i].triangle_index)) {
+				mismatches++;
+			}
+		}
+	}
+	std::cout << "# mismatches between single ray and packet results: " << mismatches << "\n";
+
+	const auto single = [&](const tics::MeshCollider &collider) {
+		return [&]() {
+			for (size_t i = 0; i < rays.size(); i++) {
+				hits[i] = tics::raycast_closest(collider, rays[i].start, rays[i].direction);
+			}
+		};
+	};
+	const auto packet = [&](const tics::MeshCollider &collider, const tics::RaycastFormulation formulation) {
+		return [&, formulation]() { tics::raycast_packet(collider, rays, hits, formulation); };
+	};
+
+	run_scenario("RaycastFanSingleLinear", iterations, single(linear_collider));
+	run_scenario("RaycastFanPacketLinearSTP", iterations, packet(linear_collider, tics::SCALAR_TRIPLE_PRODUCT));
+	run_scenario("RaycastFanPacketLinearPlucker", iterations, packet(linear_collider, tics::PLUCKER));
+	run_scenario("RaycastFanSingleBVH", iterations, single(cooked_collider));
+	run_scenario("RaycastFanPacketBVHSTP", iterations, packet(cooked_collider, tics::SCALAR_TRIPLE_PRODUCT));
+	run_scenario("RaycastFanPacketBVHPlucker", iterations, packet(cooked_collider, tics::PLUCKER));
+
+	return mismatches == 0 ? 0 : 1;
+}
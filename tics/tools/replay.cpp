@@ -0,0 +1,75 @@
+// Headless replay of a recording made with tics::World::start_recording.
+// Simulates the recorded steps again without rendering, checks that every step ends in the recorded state
+// and prints one sample per step and call ("<call> <nanoseconds>"), ready for tics_bench_compare.
+// Steps before first_step are simulated but not measured.
+//
+// Usage: tics_replay <recording> [first_step] [last_step]
+
+#include <tics.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+int main(int argc, char *argv[]) {
+	if (argc < 2) {
+		std::cerr << "usage: tics_replay <recording> [first_step] [last_step]\n";
+		return 2;
+	}
+	const std::string path = argv[1];
+	const size_t first_step = argc > 2 ? std::stoul(argv[2]) : 0;
+	const size_t last_step = argc > 3 ? std::stoul(argv[3]) : std::numeric_limits<size_t>::max();
+
+	// the world prints its own timings, keep them out of the samples
+	std::ostringstream silenced;
+	auto *stdout_buffer = std::cout.rdbuf();
+
+	tics::Replay replay;
+	std::cout.rdbuf(silenced.rdbuf());
+	const auto opened = replay.open(path);
+	std::cout.rdbuf(stdout_buffer);
+	if (!opened) {
+		std::cerr << path << ": not a recording of this tics build\n";
+		return 2;
+	}
+
+	std::vector<tics::ReplayStep> steps;
+	size_t first_divergence = std::numeric_limits<size_t>::max();
+	auto step = tics::ReplayStep();
+	while (true) {
+		std::cout.rdbuf(silenced.rdbuf());
+		const auto stepped = replay.step(step);
+		std::cout.rdbuf(stdout_buffer);
+		silenced.str("");
+		if (!stepped || step.index > last_step) { break; }
+
+		if (!step.state_matches) { first_divergence = std::min(first_divergence, step.index); }
+		if (step.index < first_step) { continue; }
+		std::cout
+			<< "ReplayUpdate " << step.update.count() << "\n"
+			<< "ReplayCollisionDetection " << step.collision_detection.count() << "\n"
+			<< "ReplayCollisionResponse " << step.collision_response.count() << "\n";
+		steps.push_back(step);
+	}
+
+	// the slowest steps are the ones worth looking at in a profiler
+	const auto total = [](const tics::ReplayStep &s) { return s.update + s.collision_detection + s.collision_response; };
+	std::sort(steps.begin(), steps.end(), [&total](const auto &a, const auto &b) { return total(a) > total(b); });
+	std::cout << "# " << steps.size() << " measured steps\n";
+	for (size_t i = 0; i < std::min<size_t>(steps.size(), 5); i++) {
+		std::cout
+			<< "# step " << steps[i].index << ": "
+			<< std::chrono::duration_cast<std::chrono::microseconds>(total(steps[i])).count() << "us, "
+			<< steps[i].collisions << " collisions\n";
+	}
+
+	if (first_divergence != std::numeric_limits<size_t>::max()) {
+		std::cout << "# diverged from the recording at step " << first_divergence << "\n";
+		return 1;
+	}
+	return 0;
+}